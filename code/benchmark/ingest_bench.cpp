@@ -0,0 +1,114 @@
+// Ingest throughput: legacy ifstream loop vs. the EdgeReader implementations.
+//
+// Build from code/:
+//   g++ -std=c++17 -O2 -o ingest_bench benchmark/ingest_bench.cpp
+// Run on a text stream (optionally also on its binary conversion):
+//   ./ingest_bench dataset/higgs-activity/higgs-activity_time_postprocess.txt [stream.bin] [repetitions]
+//
+// Every reader must reach the same edge count and checksum; a mismatch is
+// reported and makes the benchmark exit with status 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../source/ingest/edge_reader_factory.h"
+
+struct ingest_result {
+    long long edges = 0;
+    long long checksum = 0;
+    double seconds = 0;
+};
+
+static void accumulate(ingest_result &r, const long long s, const long long d, const long long l, const long long t) {
+    r.edges++;
+    r.checksum = r.checksum * 31 + (s ^ (d << 1) ^ (l << 2) ^ t);
+}
+
+// The loop main.cpp used before the EdgeReader interface.
+static ingest_result run_ifstream(const std::string &path) {
+    ingest_result r;
+    std::ifstream fin(path);
+    long long s, d, l, t;
+    while (fin >> s >> d >> l >> t) accumulate(r, s, d, l, t);
+    return r;
+}
+
+static ingest_result run_reader(const std::string &format, const std::string &path) {
+    ingest_result r;
+    const auto reader = EdgeReaderFactory::create(format, path);
+    if (!reader->is_open()) {
+        std::cerr << "Error: cannot open " << path << " as " << format << std::endl;
+        std::exit(1);
+    }
+    stream_edge e{};
+    while (reader->next(e)) accumulate(r, e.s, e.d, e.l, e.t);
+    return r;
+}
+
+// Best of `repetitions` runs, so that the first one also warms the page cache.
+static ingest_result measure(const std::function<ingest_result()> &run, const int repetitions) {
+    ingest_result best;
+    for (int i = 0; i < repetitions; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        ingest_result r = run();
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || r.seconds < best.seconds) best = r;
+    }
+    return best;
+}
+
+static std::uintmax_t file_size(const std::string &path) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    return f ? static_cast<std::uintmax_t>(f.tellg()) : 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <text_stream> [binary_stream] [repetitions]" << std::endl;
+        return 1;
+    }
+    const std::string text_path = argv[1];
+    const std::string binary_path = argc > 2 ? argv[2] : "";
+    const int repetitions = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+    struct candidate {
+        std::string name;
+        std::string path;
+        std::function<ingest_result()> run;
+    };
+    std::vector<candidate> candidates = {
+        {"ifstream loop", text_path, [&] { return run_ifstream(text_path); }},
+        {"text", text_path, [&] { return run_reader("text", text_path); }},
+        {"mmap", text_path, [&] { return run_reader("mmap", text_path); }},
+    };
+    if (!binary_path.empty())
+        candidates.push_back({"binary", binary_path, [&] { return run_reader("binary", binary_path); }});
+
+    std::cout << std::left << std::setw(16) << "reader" << std::right << std::setw(12) << "edges"
+            << std::setw(12) << "seconds" << std::setw(14) << "Medges/s" << std::setw(10) << "MB/s" << std::endl;
+
+    ingest_result reference;
+    bool consistent = true;
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        const auto &c = candidates[i];
+        const ingest_result r = measure(c.run, repetitions);
+        if (i == 0) reference = r;
+        const bool same = r.edges == reference.edges && r.checksum == reference.checksum;
+        consistent &= same;
+
+        const double megabytes = static_cast<double>(file_size(c.path)) / (1 << 20);
+        std::cout << std::left << std::setw(16) << c.name << std::right << std::setw(12) << r.edges
+                << std::fixed << std::setprecision(3) << std::setw(12) << r.seconds
+                << std::setw(14) << (r.seconds > 0 ? r.edges / r.seconds / 1e6 : 0)
+                << std::setw(10) << std::setprecision(1) << (r.seconds > 0 ? megabytes / r.seconds : 0)
+                << (same ? "" : "  MISMATCH") << std::endl;
+    }
+    return consistent ? 0 : 1;
+}
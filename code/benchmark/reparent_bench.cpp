@@ -0,0 +1,125 @@
+// Re-parenting cost on high fan-out spanning trees: the child-list scan the
+// forests used before tree_node::prev_brother vs. RPQ_tree's constant-time
+// unlink.
+//
+// Build from code/:
+//   g++ -std=c++17 -O2 -o reparent_bench benchmark/reparent_bench.cpp
+// Run:
+//   ./reparent_bench [operations] [max_fan_out]
+//
+// Each tree is a root with two hubs and fan_out leaves split between them,
+// the star shape hub vertices produce. Two workloads run on it:
+//   reparent  a leaf moves to the other hub (substitute_parent, as on a
+//             timestamp improvement in expand or a shed reconnection)
+//   churn     a leaf is deleted and added back (separate_node, as on expiry)
+// Both variants must leave the same child lists; a mismatch is reported and
+// makes the benchmark exit with status 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../source/forest_struct.h"
+
+struct reparent_result {
+    long long checksum = 0;
+    double seconds = 0;
+};
+
+// The unlink RPQ_tree did before prev_brother: find the predecessor by
+// walking the child list of the parent.
+static void legacy_unlink(tree_node *child) {
+    if (child->parent->child == child) {
+        child->parent->child = child->brother;
+        return;
+    }
+    tree_node *tmp = child->parent->child;
+    while (tmp != nullptr && tmp->brother != child) tmp = tmp->brother;
+    if (!tmp) {
+        std::cerr << "Error: child node not found in the child list of its parent." << std::endl;
+        std::exit(1);
+    }
+    tmp->brother = child->brother;
+}
+
+static void legacy_substitute_parent(tree_node *parent, tree_node *child) {
+    legacy_unlink(child);
+    child->parent = parent;
+    child->brother = parent->child;
+    parent->child = child;
+}
+
+// Child lists of both hubs in order, folded into one value.
+static long long child_lists_checksum(const RPQ_tree<2> &tree) {
+    long long checksum = 0;
+    for (const tree_node *hub = tree.root->child; hub; hub = hub->brother) {
+        checksum = checksum * 31 + hub->node_ID;
+        for (const tree_node *leaf = hub->child; leaf; leaf = leaf->brother)
+            checksum = checksum * 31 + leaf->node_ID;
+    }
+    return checksum;
+}
+
+static reparent_result run(const bool legacy, const bool churn, const unsigned int fan_out, const long long operations) {
+    RPQ_tree<2> tree;
+    tree.root = tree.add_node(0, 0, nullptr, MAX_INT, MAX_INT);
+    tree_node *hubs[2] = {tree.add_node(1, 1, tree.root, 1, 1), tree.add_node(2, 1, tree.root, 1, 1)};
+    std::vector<tree_node *> leaves(fan_out);
+    for (unsigned int i = 0; i < fan_out; i++)
+        leaves[i] = tree.add_node(3 + i, 1, hubs[i % 2], 1, 1);
+
+    unsigned long long seed = 88172645463325252ULL; // xorshift64, the same sequence for both variants
+    reparent_result r;
+    const auto start = std::chrono::steady_clock::now();
+    for (long long op = 0; op < operations; op++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        tree_node *&leaf = leaves[seed % fan_out];
+        tree_node *hub = leaf->parent == hubs[0] ? hubs[1] : hubs[0];
+        if (!churn) {
+            if (legacy) legacy_substitute_parent(hub, leaf);
+            else tree.substitute_parent(hub, leaf);
+            continue;
+        }
+        const unsigned int v = leaf->node_ID;
+        if (legacy) {
+            legacy_unlink(leaf);
+            tree.remove_node(leaf);
+        } else
+            tree.delete_node(leaf);
+        delete leaf;
+        leaf = tree.add_node(v, 1, hub, 1, 1);
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.checksum = child_lists_checksum(tree);
+    return r;
+}
+
+int main(int argc, char *argv[]) {
+    const long long operations = argc > 1 ? std::max(1LL, std::atoll(argv[1])) : 20000;
+    const unsigned int max_fan_out = argc > 2 ? std::max(16, std::atoi(argv[2])) : 65536;
+
+    std::cout << std::left << std::setw(10) << "workload" << std::right << std::setw(10) << "fan-out"
+            << std::setw(14) << "scan s" << std::setw(14) << "linked s" << std::setw(10) << "speedup" << std::endl;
+
+    bool consistent = true;
+    for (const bool churn : {false, true}) {
+        for (unsigned int fan_out = 16; fan_out <= max_fan_out; fan_out *= 16) {
+            const reparent_result scan = run(true, churn, fan_out, operations);
+            const reparent_result linked = run(false, churn, fan_out, operations);
+            const bool same = scan.checksum == linked.checksum;
+            consistent &= same;
+            std::cout << std::left << std::setw(10) << (churn ? "churn" : "reparent") << std::right
+                    << std::setw(10) << fan_out << std::fixed << std::setprecision(4)
+                    << std::setw(14) << scan.seconds << std::setw(14) << linked.seconds
+                    << std::setprecision(1) << std::setw(10) << (linked.seconds > 0 ? scan.seconds / linked.seconds : 0)
+                    << (same ? "" : "  MISMATCH") << std::endl;
+        }
+    }
+    return consistent ? 0 : 1;
+}
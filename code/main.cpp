@@ -9,15 +9,20 @@
 #include <algorithm>
 #include <cmath>
 
-#define MEMORY_PROFILER false
-
 #include "sys/types.h"
 
 #include "source/fsa.h"
 #include "source/streaming_graph.h"
 #include "source/query_handler.h"
+#include "source/vertex_dictionary.h"
+#include "source/checkpoint.h"
 #include "source/modes/mode_handler.h"
 #include "source/modes/mode_factory.h"
+#include "source/ingest/edge_reader_factory.h"
+#include "source/ingest/edge_source.h"
+#include "source/ingest/merging_edge_reader.h"
+#include "source/ingest/replay_edge_reader.h"
+#include "source/ingest/reordering_edge_reader.h"
 
 namespace fs = std::filesystem;
 using namespace std;
@@ -29,9 +34,27 @@ int main(int argc, char *argv[]) {
     string config_path = argv[1];
     config config = readConfig(config_path);
 
-    fs::path data_path = fs::current_path() / config.input_data_path;
-    std::string data_folder = data_path.parent_path().filename().string();
-    data_path = fs::absolute(data_path).lexically_normal();
+    // input_data_path lists one or more shards; a directory stands for all files in it, in name order
+    std::vector<fs::path> data_paths;
+    std::string data_folder;
+    for (const auto &entry : config.input_data_paths) {
+        fs::path data_path = fs::absolute(fs::current_path() / entry).lexically_normal();
+        if (data_folder.empty()) data_folder = data_path.parent_path().filename().string();
+        if (fs::is_directory(data_path)) {
+            std::vector<fs::path> files;
+            for (const auto &file : fs::directory_iterator(data_path)) {
+                if (file.is_regular_file()) files.push_back(file.path());
+            }
+            std::sort(files.begin(), files.end());
+            data_paths.insert(data_paths.end(), files.begin(), files.end());
+        } else {
+            data_paths.push_back(data_path);
+        }
+    }
+    if (data_paths.empty()) {
+        std::cerr << "Error: no input files in " << config.input_data_path << std::endl;
+        exit(1);
+    }
 
     cout << "Dataset: " << data_folder << endl;
 
@@ -41,10 +64,33 @@ int main(int argc, char *argv[]) {
     std::cout << "Config folder: " << config_folder_name << std::endl;
 
 
-    std::ifstream fin(data_path);
-    if (!fin.is_open()) {
-        std::cerr << "Error: Failed to open " << data_path << std::endl;
-        exit(1);
+    std::vector<std::unique_ptr<EdgeReader>> shards;
+    for (const auto &data_path : data_paths) {
+        shards.push_back(EdgeReaderFactory::create(config.input_format, data_path.string(), config.time_encoding));
+        if (!shards.back()->is_open()) {
+            std::cerr << "Error: Failed to open " << data_path << std::endl;
+            exit(1);
+        }
+    }
+    std::unique_ptr<EdgeReader> reader = shards.size() == 1
+        ? std::move(shards.front())
+        : std::make_unique<MergingEdgeReader>(std::move(shards));
+    if (data_paths.size() > 1) cout << "Merging " << data_paths.size() << " input files by timestamp" << endl;
+    ReorderingEdgeReader *reorder = nullptr;
+    if (config.max_lateness >= 0) {
+        auto reordering = std::make_unique<ReorderingEdgeReader>(std::move(reader), config.max_lateness,
+                                                                 config.reorder_capacity);
+        reorder = reordering.get();
+        reader = std::move(reordering);
+        cout << "Reordering edges, max lateness: " << config.max_lateness << endl;
+    }
+    if (config.replay) {
+        reader = std::make_unique<ReplayEdgeReader>(std::move(reader), config.rate_profile, config.replay_speed);
+        cout << "Replay profile: " << (config.replay_profile.empty() ? "none" : config.replay_profile)
+             << ", base rate x" << config.replay_rate;
+        if (config.replay_speed > 0) cout << ", paced at " << config.replay_speed << " units/s";
+        cout << endl;
+        data_folder += "_" + config.replay_tag;
     }
     // if max size < min size, exit
     if (config.max_size < config.min_size) {
@@ -68,10 +114,19 @@ int main(int argc, char *argv[]) {
         : config.rate_volatility / (1.0 + config.rate_volatility);
     ctx.granularity = config.granularity;
     ctx.max_shed = config.max_shed;
+    ctx.memory_profiler = config.memory_profiler;
 
     ctx.sink = new Sink();
-    ctx.aut = new FiniteStateAutomaton(config.query_type, config.labels);
-    ctx.sg = new streaming_graph(ctx.aut->getInitialTransitionLabels());
+    VertexDictionary vertices; // external vertex IDs -> dense IDs used by the graph and the forests
+    ctx.sink->setVertexDictionary(&vertices);
+    ctx.aut = config.query.empty() ? new FiniteStateAutomaton(config.query_type, config.labels)
+                                   : new FiniteStateAutomaton(config.compiled_query);
+    if (!config.query.empty()) {
+        cout << "Query: " << config.query << " (" << config.compiled_query.states << " states)" << endl;
+    }
+    // only load shedding (mode 5) looks edges up by ID; edges are stored in one pane per slide
+    ctx.sg = new streaming_graph(ctx.aut->getInitialTransitionLabels(), config.adjacency, config.mode == 5,
+                                 config.slide > 0 ? config.slide : config.size);
     ctx.q = new QueryHandler(*ctx.aut, *ctx.sg, *ctx.sink, config.path_algorithm);
 
     // Create mode handler using factory
@@ -82,6 +137,17 @@ int main(int argc, char *argv[]) {
     ctx.processed_elements_type.resize(labels_size + 1, 0);
     ctx.input_rate_type.resize(labels_size + 1, 0.0);
 
+    const bool restoring = !config.restore_from.empty();
+    const std::string fingerprint = checkpoint_fingerprint(config);
+    StreamProgress progress;
+    if (restoring) {
+        progress = restore_checkpoint(config.restore_from, fingerprint, ctx, *mode_handler, vertices);
+        rehash_stats::count = progress.rehashes;
+        rehash_stats::seconds = progress.rehash_seconds;
+        cout << "Restored checkpoint " << config.restore_from << " (" << ctx.edge_number << " edges, "
+             << ctx.windows.size() << " windows)" << endl;
+    }
+
     std::string mode;
     switch (config.mode) {
         case 10: mode = "sl";
@@ -176,7 +242,7 @@ int main(int argc, char *argv[]) {
     std::string base;
     const std::string radix =
         data_folder + "_" +
-            std::to_string(config.query_type) + "_" +
+            (config.query.empty() ? std::to_string(config.query_type) : config.query_tag) + "_" +
                 std::to_string(config.size) + "_" +
                     std::to_string(config.slide) + "_" +
                         mode + "_" +
@@ -203,6 +269,7 @@ int main(int argc, char *argv[]) {
     const fs::path windows_path = output_folder / (base + "_window_results.csv");
     const fs::path memory_path  = output_folder / (base + "_functions_results.csv");
     const fs::path slides_path  = output_folder / (base + "_slides_results.csv");
+    const fs::path late_path    = output_folder / (base + "_late_edges.csv");
 
     std::ofstream csv_summary(summary_path.string());
     csv_summary << "total_edges,matches,exec_time,windows_created,avg_window_cardinality,avg_window_size\n";
@@ -214,74 +281,147 @@ int main(int argc, char *argv[]) {
     // std::ofstream csv_tuples(tuples_path.string());
     // csv_tuples << "window_id,beta_id,timestamp,estimated_cost,normalized_estimated_cost,latency,beta_latency,window_cardinality,window_size,shedding\n";
 
-    std::ofstream csv_memory(memory_path.string());
-    csv_memory << "alef,avg_deg,lef,max_deg,nm\n";
+    // a restored run continues the functions CSV where the checkpoint left it
+    std::ofstream csv_memory;
+    if (restoring && fs::exists(memory_path) && fs::file_size(memory_path) >= progress.functions_csv_bytes) {
+        fs::resize_file(memory_path, progress.functions_csv_bytes);
+        csv_memory.open(memory_path.string(), std::ios::app);
+    } else {
+        if (restoring) cerr << "Warning: " << memory_path << " is missing rows from before the checkpoint" << endl;
+        csv_memory.open(memory_path.string());
+        csv_memory << "alef,avg_deg,lef,max_deg,nm\n";
+    }
 
     std::ofstream csv_slides(slides_path.string());
-    csv_slides << "t_open,t_close,latency_sec,elements,new_results,cost_norm\n";
+    csv_slides << "t_open,t_close,latency_sec,elements,new_results,cost_norm,rehashes,rehash_sec";
+    if (config.memory_profiler) csv_slides << "," << memory_usage::csv_columns;
+    csv_slides << "\n";
 
     //ctx.csv_tuples = &csv_tuples;
     ctx.csv_memory = &csv_memory;
+
+    // side output of the reorder buffer
+    std::ofstream csv_late;
+    if (reorder) {
+        csv_late.open(late_path.string());
+        csv_late << "s,d,l,t,lateness\n";
+        reorder->set_late_output(&csv_late);
+    }
     long long checkpoint = 300000;
 
-    int elements_processed = 0;
-    double cumulative_processing_time = 0;
-
-    clock_t start = clock();
-    ctx.beta_latency_start = clock();
-
-    long long t0 = 0;
-    long long time;
-    ctx.windows.emplace_back(0, config.size, nullptr, nullptr, 0);
-    long long s, d, l, t;
-    while (fin >> s >> d >> l >> t) {
-        if (t0 == 0) t0 = t;
-        time = t - t0;
-        if (time < 0) continue;
-        if (time == 0) time = 1;
-
-        // process the edge if the label is part of the query
-        if (!ctx.aut->hasLabel(l))
-            continue;
-
-        sg_edge *new_sgt = nullptr;
-        bool is_shed = false;
-        clock_t processing_time_start = clock();
-
-        is_shed = mode_handler->process_edge(s, d, l, time, ctx, &new_sgt);
-        if (new_sgt) {  // Only process query if an edge was created (not shed in load shedding mode)
-            ctx.q->run(new_sgt);
-        }
+    int elements_processed = static_cast<int>(progress.elements_processed);
+    double cumulative_processing_time = progress.cumulative_processing_time;
 
-        elements_processed++;
-        double processing_time_used = static_cast<double>(clock() - processing_time_start) / CLOCKS_PER_SEC;
-        if (!is_shed) { // compute the average time used do process an event in a steady state of the stream
-            cumulative_processing_time += processing_time_used;
-            ctx.average_processing_time = cumulative_processing_time / static_cast<double>(elements_processed);
+    EdgePrefilter prefilter(*ctx.aut);
+    if (restoring) {
+        prefilter.resume(progress.t0, progress.records);
+        // a live producer only sends what is new
+        if (!EdgeReaderFactory::is_live(config.input_format) && reader->skip(progress.records) < progress.records) {
+            cerr << "Error: the input is shorter than the checkpointed stream" << endl;
+            exit(1);
         }
-        // compute metrics per type
-        ctx.cumulative_processing_time_type[l] += processing_time_used;
-        ctx.processed_elements_type[l]++;
-        ctx.input_rate_type[l] = ctx.processed_elements_type[l] / static_cast<double>(clock() - start);
-
-        if (elements_processed % checkpoint == 0) {
-            printf("processed edges: %d\n", elements_processed);
-            printf("avg degree: %f\n", ctx.sg->edge_num/ctx.sg->vertex_num);
-            cout << std::fixed << std::setprecision(5);
-            cout << "average processing time: " << ctx.average_processing_time << " seconds\n";
-            cout << "matched paths: " << ctx.sink->matched_paths << "\n\n";
+    }
+
+    std::unique_ptr<EdgeSource> source;
+    if (config.pipelined_ingest) {
+        cout << "Pipelined ingest, queue capacity: " << config.ingest_queue_capacity << endl;
+        source = std::make_unique<PipelinedEdgeSource>(std::move(reader), prefilter, config.ingest_queue_capacity);
+    } else {
+        source = std::make_unique<SerialEdgeSource>(std::move(reader), prefilter);
+    }
+
+    clock_t start = processing_clock() - static_cast<clock_t>(progress.processing_seconds * CLOCKS_PER_SEC);
+    if (!restoring) ctx.beta_latency_start = processing_clock();
+
+    // checkpoints are taken on slide boundaries (window resizes in ADWIN mode)
+    size_t boundaries_at_checkpoint = ctx.slides.size() + ctx.resizings;
+    const auto write_checkpoint = [&](const ingest_edge &last) {
+        csv_memory.flush();
+        StreamProgress snapshot;
+        snapshot.records = last.offset;
+        snapshot.t0 = source->origin();
+        snapshot.elements_processed = elements_processed;
+        snapshot.cumulative_processing_time = cumulative_processing_time;
+        snapshot.processing_seconds = static_cast<double>(processing_clock() - start) / CLOCKS_PER_SEC;
+        snapshot.slides_at_reclaim = progress.slides_at_reclaim;
+        snapshot.functions_csv_bytes = static_cast<std::uint64_t>(csv_memory.tellp());
+        snapshot.rehashes = rehash_stats::count;
+        snapshot.rehash_seconds = rehash_stats::seconds;
+        save_checkpoint(config.checkpoint_path, fingerprint, ctx, *mode_handler, vertices, snapshot);
+        boundaries_at_checkpoint = ctx.slides.size() + ctx.resizings;
+    };
+
+    // dense vertex IDs are reclaimed once per slide, or earlier if many are queued
+    size_t &slides_at_reclaim = progress.slides_at_reclaim;
+    const auto reclaim_vertices = [&] {
+        vertices.reclaim([&](const uint32_t v) { return ctx.sg->has_vertex(v); },
+                         [&](const uint32_t v) { return ctx.q->holds_vertex(v); });
+        slides_at_reclaim = ctx.slides.size();
+    };
+
+    if (!restoring) ctx.windows.emplace_back(0, config.size, 0);
+    std::vector<ingest_edge> batch(EdgeSource::batch_size);
+    while (const size_t batch_count = source->next_batch(batch.data(), batch.size())) {
+        for (size_t i = 0; i < batch_count; i++) {
+            const auto &[external_s, external_d, l, time, offset] = batch[i];
+            const uint32_t s = vertices.encode(external_s);
+            const uint32_t d = vertices.encode(external_d);
+
+            sg_edge *new_sgt = nullptr;
+            bool is_shed = false;
+            clock_t processing_time_start = processing_clock();
+
+            is_shed = mode_handler->process_edge(s, d, l, time, ctx, &new_sgt);
+            if (new_sgt) {  // Only process query if an edge was created (not shed in load shedding mode)
+                ctx.q->run(new_sgt);
+            } else {
+                vertices.add_candidate(s);
+                vertices.add_candidate(d);
+            }
+            for (const long long v : ctx.sg->isolated_vertices) vertices.add_candidate(v);
+            ctx.sg->isolated_vertices.clear();
+            if (ctx.slides.size() != slides_at_reclaim || vertices.reclaim_due()) reclaim_vertices();
+
+            elements_processed++;
+            double processing_time_used = static_cast<double>(processing_clock() - processing_time_start) / CLOCKS_PER_SEC;
+            if (!is_shed) { // compute the average time used do process an event in a steady state of the stream
+                cumulative_processing_time += processing_time_used;
+                ctx.average_processing_time = cumulative_processing_time / static_cast<double>(elements_processed);
+            }
+            // compute metrics per type
+            ctx.cumulative_processing_time_type[l] += processing_time_used;
+            ctx.processed_elements_type[l]++;
+            ctx.input_rate_type[l] = ctx.processed_elements_type[l] / static_cast<double>(processing_clock() - start);
+
+            if (elements_processed % checkpoint == 0) {
+                printf("processed edges: %d\n", elements_processed);
+                printf("avg degree: %f\n", ctx.sg->edge_num/ctx.sg->vertex_num);
+                cout << std::fixed << std::setprecision(5);
+                cout << "average processing time: " << ctx.average_processing_time << " seconds\n";
+                cout << "matched paths: " << ctx.sink->matched_paths << "\n\n";
+            }
+
+            if (!config.checkpoint_path.empty() &&
+                ctx.slides.size() + ctx.resizings >= boundaries_at_checkpoint + config.checkpoint_every) {
+                write_checkpoint(batch[i]);
+            }
         }
     }
     if (!ctx.slides.empty()) {
-        ctx.slides.back().wall_close = clock();
+        ctx.slides.back().wall_close = processing_clock();
         ctx.slides.back().results_at_close = ctx.sink->matched_paths;
+        ctx.slides.back().rehashes_at_close = rehash_stats::count;
+        ctx.slides.back().rehash_sec_at_close = rehash_stats::seconds;
+        if (config.memory_profiler) ctx.slides.back().memory = measure_memory(ctx);
     }
-    clock_t finish = clock();
+    clock_t finish = processing_clock();
     long long time_used = static_cast<double> (finish - start) / CLOCKS_PER_SEC;
 
     cout << "Created windows: " << ctx.windows.size() << endl;
     cout << "Total execution time: " << time_used << " seconds" << endl;
     cout << "Shed edges: " << ctx.sg->shed_count << endl;
+    if (reorder) cout << "Late edges: " << reorder->late_count() << endl;
+    cout << "Forest rehashes: " << rehash_stats::count << " (" << rehash_stats::seconds << " seconds)" << endl;
 
     double avg_window_size = static_cast<double>(ctx.total_elements_count) / ctx.windows.size();
 
@@ -307,14 +447,21 @@ int main(int argc, char *argv[]) {
                 << ctx.windows[i].t_close - ctx.windows[i].t_open << "\n";
     }
 
-    for (auto&[t_open, t_close, wall_open, wall_close, elements_count, results_at_open, results_at_close, cost_norm] : ctx.slides) {
-        double latency = static_cast<double>(wall_close - wall_open) / CLOCKS_PER_SEC;
-        csv_slides << t_open << ","
-                   << t_close << ","
+    for (const Slide &slide : ctx.slides) {
+        double latency = static_cast<double>(slide.wall_close - slide.wall_open) / CLOCKS_PER_SEC;
+        csv_slides << slide.t_open << ","
+                   << slide.t_close << ","
                    << latency << ","
-                   << elements_count << ","
-                   << (results_at_close - results_at_open) << ","
-                   << cost_norm << "\n";
+                   << slide.elements_count << ","
+                   << (slide.results_at_close - slide.results_at_open) << ","
+                   << slide.cost_norm << ","
+                   << (slide.rehashes_at_close - slide.rehashes_at_open) << ","
+                   << (slide.rehash_sec_at_close - slide.rehash_sec_at_open);
+        if (config.memory_profiler) {
+            csv_slides << ",";
+            slide.memory.write_csv(csv_slides);
+        }
+        csv_slides << "\n";
     }
 
     // ctx.sink->exportResultSet(base + "_result_set.csv");
@@ -0,0 +1,90 @@
+import argparse
+import struct
+
+MAGIC = b"ADAE"
+VERSION = 1
+
+
+def read_edges(input_file):
+    """
+    Yields (s, d, l, t) tuples from a whitespace-separated "s d l t" stream,
+    with the same token semantics as the text reader in main.cpp.
+    """
+    with open(input_file, 'r') as infile:
+        tokens = []
+        for line in infile:
+            tokens.extend(line.split())
+            while len(tokens) >= 4:
+                s, d, l, t = tokens[:4]
+                del tokens[:4]
+                yield int(s), int(d), int(l), int(t)
+
+
+def zigzag(v):
+    return (v << 1) ^ (v >> 63)
+
+
+def varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return out
+
+
+def scan(input_file):
+    """
+    First pass: collects the label dictionary, the first timestamp and the number of records.
+    """
+    labels = {}
+    t_origin = None
+    count = 0
+    for _, _, l, t in read_edges(input_file):
+        if t_origin is None:
+            t_origin = t
+        if l not in labels:
+            labels[l] = len(labels)
+        count += 1
+    return labels, (t_origin or 0), count
+
+
+def convert(input_file, output_file):
+    """
+    Second pass: writes the header described in source/ingest/binary_edge_reader.h followed by
+    one varint record per edge, with timestamps delta-encoded against the previous record.
+    """
+    labels, t_origin, count = scan(input_file)
+    with open(output_file, 'wb') as outfile:
+        outfile.write(MAGIC)
+        outfile.write(struct.pack('<HHqQI', VERSION, 0, t_origin, count, len(labels)))
+        for label in labels:
+            outfile.write(struct.pack('<q', label))
+
+        t_prev = t_origin
+        chunk = bytearray()
+        for s, d, l, t in read_edges(input_file):
+            chunk += varint(zigzag(s))
+            chunk += varint(zigzag(d))
+            chunk += varint(labels[l])
+            chunk += varint(zigzag(t - t_prev))
+            t_prev = t
+            if len(chunk) >= 1 << 20:
+                outfile.write(chunk)
+                chunk = bytearray()
+        outfile.write(chunk)
+    return count, len(labels)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert an 's d l t' edge stream to the binary input_format.")
+    parser.add_argument("input_file", help="text edge stream, e.g. *_time_postprocess.txt")
+    parser.add_argument("output_file", help="binary edge stream to write")
+    args = parser.parse_args()
+
+    count, label_count = convert(args.input_file, args.output_file)
+    print(f"Converted {count} edges ({label_count} labels) into: {args.output_file}")
+
+
+if __name__ == "__main__":
+    main()
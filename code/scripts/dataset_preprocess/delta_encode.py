@@ -0,0 +1,43 @@
+import argparse
+import gzip
+
+from convert_to_binary import read_edges
+
+
+def open_output(output_file):
+    """
+    Opens the output as gzip text when its name ends in .gz, as plain text otherwise.
+    """
+    if output_file.endswith('.gz'):
+        return gzip.open(output_file, 'wt', compresslevel=9)
+    return open(output_file, 'w')
+
+
+def delta_encode(input_file, output_file):
+    """
+    Rewrites an "s d l t" stream as "s d l dt", where dt is the difference to the previous
+    record's timestamp (the first record keeps its absolute timestamp). Read it back with
+    time_encoding=delta.
+    """
+    count = 0
+    t_prev = 0
+    with open_output(output_file) as outfile:
+        for s, d, l, t in read_edges(input_file):
+            outfile.write(f"{s} {d} {l} {t - t_prev}\n")
+            t_prev = t
+            count += 1
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Delta-encode the timestamps of an 's d l t' edge stream.")
+    parser.add_argument("input_file", help="text edge stream, e.g. *_time_postprocess.txt")
+    parser.add_argument("output_file", help="delta-encoded stream to write; gzip-compressed if it ends in .gz")
+    args = parser.parse_args()
+
+    count = delta_encode(args.input_file, args.output_file)
+    print(f"Delta-encoded {count} edges into: {args.output_file}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+import argparse
+import os
+import socket
+import struct
+import sys
+
+SHUTDOWN = 0xFFFFFFFF
+RECORD = struct.Struct('<qqqq')
+
+
+def read_edges(input_file):
+    """
+    Yields (s, d, l, t) tuples from an "s d l t" text stream.
+    """
+    with open(input_file, 'r') as infile:
+        for line in infile:
+            fields = line.split()
+            if len(fields) < 4:
+                continue
+            yield tuple(int(x) for x in fields[:4])
+
+
+def frame(edges):
+    return struct.pack('<I', len(edges)) + b''.join(RECORD.pack(*e) for e in edges)
+
+
+def recv_ack(conn):
+    data = b''
+    while len(data) < 4:
+        chunk = conn.recv(4 - len(data))
+        if not chunk:
+            raise ConnectionError("server closed the connection")
+        data += chunk
+    return struct.unpack('<I', data)[0]
+
+
+def send_edges(input_file, path, fifo, batch, shutdown):
+    """
+    Sends the edges of input_file to a running main_exe (input_format=socket or fifo) in frames of
+    `batch` edges. On a socket each frame's ack is awaited before the next frame is sent.
+    """
+    if fifo:
+        out = open(path, 'wb', buffering=0)
+        write, ack = out.write, lambda: None
+    else:
+        out = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        out.connect(path)
+        write, ack = out.sendall, lambda: recv_ack(out)
+
+    count = 0
+    edges = []
+    with out:
+        for e in read_edges(input_file):
+            edges.append(e)
+            if len(edges) == batch:
+                write(frame(edges))
+                ack()
+                count += len(edges)
+                edges = []
+        if edges:
+            write(frame(edges))
+            ack()
+            count += len(edges)
+        if shutdown:
+            write(struct.pack('<I', SHUTDOWN))
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stream an 's d l t' edge file to main_exe running in server mode.")
+    parser.add_argument("input_file", help="text edge stream")
+    parser.add_argument("path", help="socket or FIFO path, i.e. the server's input_data_path")
+    parser.add_argument("--fifo", action="store_true", help="path is a FIFO (input_format=fifo)")
+    parser.add_argument("--batch", type=int, default=1024, help="edges per frame (default 1024)")
+    parser.add_argument("--shutdown", action="store_true", help="end the server's run after the last frame")
+    args = parser.parse_args()
+
+    if args.fifo and not os.path.exists(args.path):
+        sys.exit(f"{args.path} does not exist; start main_exe first")
+    count = send_edges(args.input_file, args.path, args.fifo, args.batch, args.shutdown)
+    print(f"Sent {count} edges to: {args.path}")
+
+
+if __name__ == "__main__":
+    main()
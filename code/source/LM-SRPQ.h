@@ -15,17 +15,20 @@
 #define merge_long_long(s, d) (((unsigned long long)s<<32)|d)
 using namespace std;
 
-class LM_SRPQ {
+template<unsigned int N>
+class LM_SRPQ { // N is the number of states of the automaton, 0 if only known at run time (see QueryProcessorFactory)
 public:
     FiniteStateAutomaton &aut;
     streaming_graph &g;
     Sink &sink;
 
     map<unsigned int, double> aut_scores; // this map stores the depth we estimated for each state in the DFA
-    unordered_map<unsigned long long, RPQ_tree *> forests; // unordered map that maps each vertex ID-state pair to the spanning tree rooted at it. the vertex ID and the state is merged into an Unsigned long long
-    map<unsigned int, tree_info_index *> v2t_index; // Maps each state to a tree_info_index, reverse index that maps a graph vertex to the normal trees that contains it.
-    map<unsigned int, lm_info_index *> v2l_index; // Maps each state to a lm_info_index, reverse index that maps a graph vertex to the LM trees that contains it.
+    unordered_map<unsigned long long, RPQ_tree<N> *> forests; // unordered map that maps each vertex ID-state pair to the spanning tree rooted at it. the vertex ID and the state is merged into an Unsigned long long
+    map<unsigned int, tree_info_index<N> *> v2t_index; // Maps each state to a tree_info_index, reverse index that maps a graph vertex to the normal trees that contains it.
+    map<unsigned int, lm_info_index<N> *> v2l_index; // Maps each state to a lm_info_index, reverse index that maps a graph vertex to the LM trees that contains it.
     unordered_set<unsigned long long> landmarks; // set of landmarks, vertex ID and states are merged.
+    unordered_set<unsigned long long> touched_trees; // roots of the trees that lost nodes, landmarks or TI map entries since the last compact()
+    vertex_refs ti_refs; // number of TI map entries of each vertex, over all LM trees. Only LM trees have a TI map.
 
     LM_SRPQ(FiniteStateAutomaton &aut, streaming_graph &g, Sink &sink)
         : aut(aut), g(g), sink(sink) {
@@ -50,7 +53,7 @@ public:
         for (const auto & deleted_edge : deleted_edges) {
             unsigned int dst = deleted_edge.dst;
             long long label = deleted_edge.label;
-            std::vector<std::pair<long long, long long> > vec = aut.getStatePairsWithTransition(label);
+            const auto &vec = aut.getStatePairsWithTransition(label);
             // dst node of the expired edge may be root of expired subtrees, get all the possible dst states/
             for (auto &[fst, snd] : vec) {
                 long long dst_state = snd;
@@ -62,8 +65,8 @@ public:
                 visited_pair.insert(merge_long_long(dst, dst_state));
                 if (auto iter = v2t_index.find(dst_state); iter != v2t_index.end()) {
                     if (auto tree_iter = iter->second->tree_index.find(dst); tree_iter != iter->second->tree_index.end()) {
-                        vector<RPQ_tree *> tree_to_delete;
-                        tree_info *tmp = tree_iter->second;
+                        vector<RPQ_tree<N> *> tree_to_delete;
+                        tree_info<N> *tmp = tree_iter->second;
                         while (tmp) {
                             tree_to_delete.push_back(tmp->tree);
                             // we first record the tree list and then check them one by one, as the deletion may change the tree list.
@@ -77,15 +80,14 @@ public:
                                 delete k;
                             }
                         }
-                        shrink(forests);
                         tree_to_delete.clear();
                     }
                 }
                 //expire in LM trees.
                 if (auto iter2 = v2l_index.find(dst_state); iter2 != v2l_index.end()) {
                     if (auto tree_iter = iter2->second->tree_index.find(dst); tree_iter != iter2->second->tree_index.end()) {
-                        vector<RPQ_tree *> tree_to_delete;
-                        tree_info *tmp = tree_iter->second;
+                        vector<RPQ_tree<N> *> tree_to_delete;
+                        tree_info<N> *tmp = tree_iter->second;
                         while (tmp) {
                             tree_to_delete.push_back(tmp->tree);
                             tmp = tmp->next;
@@ -104,7 +106,6 @@ public:
                                 delete k;
                             }
                         }
-                        shrink(forests);
                         tree_to_delete.clear();
                     }
                 }
@@ -117,7 +118,8 @@ public:
         if (aut.getNextState(0, label) != -1 && forests.find(merge_long_long(s, 0)) == forests.end())
         // we need to build a new tree
         {
-            auto *new_tree = new RPQ_tree();
+            auto *new_tree = new RPQ_tree<N>(aut.states());
+            new_tree->count_time_info(&ti_refs);
             if (landmarks.find(merge_long_long(s, 0)) == landmarks.end()) // a normal tree
                 new_tree->root = add_node(new_tree, s, 0, s, nullptr, MAX_INT, MAX_INT);
             else {
@@ -127,21 +129,21 @@ public:
             }
             forests[merge_long_long(s, 0)] = new_tree;
         }
-        vector<pair<long long, long long> > vec = aut.getStatePairsWithTransition(label); // find all the state paris that can accept this label
+        const auto &vec = aut.getStatePairsWithTransition(label); // find all the state paris that can accept this label
         for (auto &[fst, snd] : vec) {
             unordered_map<unsigned long long, vector<pair<unsigned int, unsigned int> > > lm_results;
             unsigned int src_state = fst;
             unsigned int dst_state = snd;
             if (landmarks.find(merge_long_long(s, src_state)) != landmarks.end()) // if (s, src_state) is a landmark
             {
-                RPQ_tree *tree_pt = forests[merge_long_long(s, src_state)];
+                RPQ_tree<N> *tree_pt = forests[merge_long_long(s, src_state)];
                 insert_edge_lm_tree(s, d, label, timestamp, src_state, dst_state, tree_pt, lm_results);
                 // update the lm tree, backtrack is also called, and the lm trees we find in backtrack and the updated reachable nodes of them are in lm_results.
                 unordered_set<unsigned int> visited;
                 // find the trees with the landmark (s, src_state) and update them. such update is a part of the backtrack. We will not expand the normal but only update the result set.
                 if (auto index_iter = v2t_index.find(src_state); index_iter != v2t_index.end()) {
                     if (auto tree_iter = index_iter->second->tree_index.find(s); tree_iter != index_iter->second->tree_index.end()) {
-                        tree_info *tmp = tree_iter->second;
+                        tree_info<N> *tmp = tree_iter->second;
                         while (tmp) {
                             visit_non_lm_tree(s, d, label, timestamp, src_state, dst_state, tmp->tree, lm_results,visited);
                             tmp = tmp->next;
@@ -154,7 +156,7 @@ public:
                     // find the normal trees containing other landmarks we find in backtrack and update them.
                     if (auto iterator = v2t_index.find(lm_state); iterator != v2t_index.end()) {
                         if (auto tree_iter = iterator->second->tree_index.find(lm_ID); tree_iter != iterator->second->tree_index.end()) {
-                            tree_info *tmp = tree_iter->second;
+                            tree_info<N> *tmp = tree_iter->second;
                             while (tmp) {
                                 visit_non_lm_tree(s, d, label, timestamp, src_state, dst_state, tmp->tree, lm_results, visited);
                                 tmp = tmp->next;
@@ -168,7 +170,7 @@ public:
                 // if (s, src_state) is not a landmark, we need to first update all the LM trees contianing it, and backtrack from them.
                 if (auto index_iter = v2l_index.find(src_state); index_iter != v2l_index.end()) {
                     if (auto tree_iter = index_iter->second->tree_index.find(s); tree_iter != index_iter->second->tree_index.end()) {
-                        tree_info *tmp = tree_iter->second;
+                        tree_info<N> *tmp = tree_iter->second;
                         while (tmp) {
                             insert_edge_lm_tree(s, d, label, timestamp, src_state, dst_state, tmp->tree, lm_results);
                             tmp = tmp->next;
@@ -178,7 +180,7 @@ public:
                 unordered_set<unsigned int> visited;
                 if (auto index_iter2 = v2t_index.find(src_state); index_iter2 != v2t_index.end()) {
                     if (auto tree_iter = index_iter2->second->tree_index.find(s); tree_iter != index_iter2->second->tree_index.end()) {
-                        tree_info *tmp = tree_iter->second;
+                        tree_info<N> *tmp = tree_iter->second;
                         while (tmp) {
                             visit_non_lm_tree(s, d, label, timestamp, src_state, dst_state, tmp->tree, lm_results,visited);
                             tmp = tmp->next;
@@ -193,7 +195,7 @@ public:
                     // update them together at last so that we ensure every LM tree has been updated, and we can directly use their time info maps safely in the normal tree update.
                     if (auto index_iter = v2t_index.find(lm_state); index_iter != v2t_index.end()) {
                         if (auto tree_iter = index_iter->second->tree_index.find(lm_ID); tree_iter != index_iter->second->tree_index.end()) {
-                            tree_info *tmp = tree_iter->second;
+                            tree_info<N> *tmp = tree_iter->second;
                             while (tmp) {
                                 visit_non_lm_tree(s, d, label, timestamp, src_state, dst_state, tmp->tree, lm_results,visited);
                                 tmp = tmp->next;
@@ -208,16 +210,66 @@ public:
         }
     }
 
+    void save(CheckpointWriter &w) const // forests, both reverse indexes and the landmark set, for checkpoints
+    {
+        save_forests(w, forests);
+        const auto keys = forest_keys(forests);
+        save_reverse_index(w, v2t_index, keys);
+        save_reverse_index(w, v2l_index, keys);
+        w.put_set(landmarks);
+    }
+
+    void load(CheckpointReader &r) // restore state written by save() into an empty LM_SRPQ
+    {
+        load_forests(r, forests, aut.states());
+        for (auto &[info, tree_pt] : forests)
+            tree_pt->count_time_info(&ti_refs);
+        load_reverse_index(r, v2t_index, forests);
+        load_reverse_index(r, v2l_index, forests);
+        r.get_set(landmarks);
+    }
+
+    void compact() // shrink the tables that lost most of their elements since the last slide
+    {
+        compact_forests(forests, touched_trees);
+        compact_reverse_index(v2t_index);
+        compact_reverse_index(v2l_index);
+        shrink(landmarks);
+    }
+
+    void measure_memory(memory_usage &m) const // live bytes of the forests, both reverse indexes and the landmark set
+    {
+        measure_forests(m, forests);
+        m.v2t_index += reverse_index_memory(v2t_index);
+        m.v2l_index += reverse_index_memory(v2l_index);
+        m.landmarks += memory_estimate::hashed(landmarks);
+        m.node_maps += ti_refs.memory();
+    }
+
+    bool holds_vertex(unsigned int v) const // true if v is a tree node, a landmark, or appears in the TI map of an LM tree. The TI maps can keep vertices that are no longer tree nodes.
+    {
+        for (const auto &[state, index] : v2t_index)
+            if (index->tree_index.find(v) != index->tree_index.end())
+                return true;
+        for (const auto &[state, index] : v2l_index)
+            if (index->tree_index.find(v) != index->tree_index.end())
+                return true;
+        for (int state = 0; state < aut.states_count; state++)
+            if (landmarks.find(merge_long_long(v, state)) != landmarks.end() || forests.find(merge_long_long(v, state)) != forests.end())
+                return true;
+        return ti_refs.holds(v);
+    }
+
     void dynamic_lm_select(double candidate_rate, double benefit_threshold)
     // the function to select landmarks, first parameter is the candidate selection rate, usually 0.2, the second is the benefit threshold, usually 1.5
     {
         vector<vertex_score> scores;
         unordered_map<unsigned long long, unsigned int> score_map; //store scores of nodes
 
-        for (auto iter = g.adjacency_list.begin(); iter != g.adjacency_list.end(); ++iter) {
+        g.for_each_source_vertex([&](const long long vertex) {
         //for (unordered_map<unsigned int, neighbor_list>::iterator iter = g.g.begin(); iter != g.g.end(); iter++) {
             unsigned int degree_sum = 0;
-            unsigned int id = iter->first;
+            unsigned int id = vertex;
             for (auto &[fst, snd] : aut.transitions) {
                 unsigned int state = fst;
                 unsigned long long info = merge_long_long(id, state);
@@ -241,7 +293,7 @@ public:
                     }
                 }
             }
-        }
+        });
         if (scores.empty())
             return;
         sort(scores.begin(), scores.end()); // socrt the scores.
@@ -262,7 +314,7 @@ public:
             unsigned long long info = *it;
             unsigned int v = (info >> 32);
             unsigned int state = (info & 0xFFFFFFFF);
-            RPQ_tree *tree_pt = nullptr;
+            RPQ_tree<N> *tree_pt = nullptr;
             if (forests.find(info) != forests.end())
             // if the LM tree of this landmark is already deleted because it becomes empty in expiration, this landmark need to be deleted from the landmark set.
                 tree_pt = forests[info];
@@ -278,6 +330,7 @@ public:
                 recover_subtree_lm(v, state, tree_pt); // rcover the subtrees
                 if (state == 0) {
                     // if the state is 0, we need to transform the LM tree back to a normal tree.
+                    touch_tree(tree_pt);
                     tree_pt->clear_time_info(); // delete the time info map
                     switch_tree_index_reverse(tree_pt); // swith the reverse index of the nodes in it from v2h to v2l
                 } else // else we need to delete this tree.
@@ -307,8 +360,6 @@ public:
             } else it++;
         }
 
-        shrink(landmarks);
-
         for (unsigned long offset = 0; offset < num; ++offset) // scan candidates
         {
             const vertex_score& candidate = scores[scores.size() - 1 - offset];
@@ -318,7 +369,7 @@ public:
             if (landmarks.find(info) != landmarks.end()) // skip a node if it is already a landmark
                 continue;
 
-            RPQ_tree *tree_pt = nullptr;
+            RPQ_tree<N> *tree_pt = nullptr;
             if (forests.find(info) != forests.end()) {
                 // if there is already a normal tree for it, it mush have state 0, and should be selected as a landmark.
                 tree_pt = forests[info];
@@ -380,42 +431,42 @@ private:
     }
 
 
-    void add_index(RPQ_tree *tree_pt, unsigned int v, unsigned int state, unsigned int root_ID)
+    void add_index(RPQ_tree<N> *tree_pt, unsigned int v, unsigned int state, unsigned int root_ID)
     // modify the reverse index when a node is added into a normal tree;
     {
         auto iter = v2t_index.find(state);
         if (iter == v2t_index.end())
-            v2t_index[state] = new tree_info_index;
+            v2t_index[state] = new tree_info_index<N>;
         v2t_index[state]->add_node(tree_pt, v, root_ID);
     }
 
-    void add_lm_index(RPQ_tree *tree_pt, unsigned int v, unsigned int state, unsigned int root_ID,
+    void add_lm_index(RPQ_tree<N> *tree_pt, unsigned int v, unsigned int state, unsigned int root_ID,
                       unsigned int root_state) // modify the reverse index when a node is added into an LM tree;
     {
         auto iter = v2l_index.find(state);
         if (iter == v2l_index.end())
-            v2l_index[state] = new lm_info_index;
+            v2l_index[state] = new lm_info_index<N>;
         v2l_index[state]->add_node(tree_pt, v, root_ID, root_state);
     }
 
-    tree_node *add_node(RPQ_tree *tree_pt, unsigned int v, unsigned int state, unsigned int root_ID, tree_node *parent,
+    tree_node *add_node(RPQ_tree<N> *tree_pt, unsigned int v, unsigned int state, unsigned int root_ID, tree_node *parent,
                         unsigned int timestamp, unsigned int edge_time,
-                        bool lm = false) // add a node to a normal tree, bool lm indicating if this node is a landmark.
+                        bool lm = false, tree_node **slot = nullptr) // add a node to a normal tree, bool lm indicating if this node is a landmark.
     {
         add_index(tree_pt, v, state, root_ID);
-        tree_node *tmp = tree_pt->add_node(v, state, parent, timestamp, edge_time);
+        tree_node *tmp = tree_pt->add_node(v, state, parent, timestamp, edge_time, slot);
         tmp->lm = lm;
         return tmp;
     }
 
 
-    tree_node *add_lm_node(RPQ_tree *lm_tree, unsigned int v, unsigned int state, unsigned int root_ID,
+    tree_node *add_lm_node(RPQ_tree<N> *lm_tree, unsigned int v, unsigned int state, unsigned int root_ID,
                            unsigned int root_state,
                            tree_node *parent, unsigned int timestamp, unsigned int edge_time,
-                           bool lm = false) // add a node to the LM tree .
+                           bool lm = false, tree_node **slot = nullptr) // add a node to the LM tree .
     {
         add_lm_index(lm_tree, v, state, root_ID, root_state);
-        tree_node *tmp = lm_tree->add_node(v, state, parent, timestamp, edge_time);
+        tree_node *tmp = lm_tree->add_node(v, state, parent, timestamp, edge_time, slot);
         tmp->lm = lm;
         return tmp;
     }
@@ -443,7 +494,7 @@ private:
     }
 
 
-    void lm_expand_in_lm_subtree(unsigned int lm, unsigned int state, RPQ_tree *root_lm_tree, unsigned int lm_time,
+    void lm_expand_in_lm_subtree(unsigned int lm, unsigned int state, RPQ_tree<N> *root_lm_tree, unsigned int lm_time,
                                  unordered_map<unsigned long long, unsigned int> &updated_nodes)
     // this function is called when a landmark (lm, state) is added into another lm tree root_lm_tree, the timestamp of this node is lm_time, we scan the LM tree of this landmark and update the time_info map
     // in root_lm_tree, besides, we record the nodes where the timestamp in the time_info map of root_lm_tree is updated with updated_nodes, we need to update the result set in the upper layer with these nodes.
@@ -451,33 +502,21 @@ private:
         unsigned long long lm_info = merge_long_long(lm, state);
         if (forests.find(lm_info) == forests.end())
             return;
-        RPQ_tree *lm_subtree = forests[lm_info]; // find the LM tree
-        for (auto state_iter = lm_subtree->time_info.begin(); state_iter != lm_subtree->time_info.end(); state_iter++) {
+        RPQ_tree<N> *lm_subtree = forests[lm_info]; // find the LM tree
+        for (unsigned int state_ = 0; state_ < lm_subtree->time_info.size(); state_++) {
             // scan its time info map
-            time_info_index *subtree_index = state_iter->second;
-            if (root_lm_tree->time_info.find(state_iter->first) == root_lm_tree->time_info.end())
-                // if this state is not in the time info map of root_lm_tree yet, add a new lm_info_index
-                root_lm_tree->time_info[state_iter->first] = new time_info_index;
-            time_info_index *root_index = root_lm_tree->time_info[state_iter->first];
+            time_info_index *subtree_index = &lm_subtree->time_info[state_];
             for (auto iter = subtree_index->index.begin(); iter != subtree_index->index.end(); iter++) {
                 unsigned int time = min(lm_time, iter->second);
                 // compute the time of latest path from root of root_lm_tree to the node
-                if (root_index->index.find(iter->first) == root_index->index.end()) {
-                    root_index->index[iter->first] = time;
-                    updated_nodes[merge_long_long(iter->first, state_iter->first)] = time;
-                } else {
-                    if (root_index->index[iter->first] < time)
-                    // if the node is not in the time info map of root_lm_tree before or has a smaller timestamp, we need to update it.
-                    {
-                        root_index->index[iter->first] = time;
-                        updated_nodes[merge_long_long(iter->first, state_iter->first)] = time;
-                    }
-                }
+                if (root_lm_tree->raise_time_info(iter->first, state_, time))
+                // if the node is not in the time info map of root_lm_tree before or has a smaller timestamp, we need to update it.
+                    updated_nodes[merge_long_long(iter->first, state_)] = time;
             }
         }
     }
 
-    void lm_expand(tree_node *expand_node, RPQ_tree *lm_tree,
+    void lm_expand(tree_node *expand_node, RPQ_tree<N> *lm_tree,
                    unordered_map<unsigned long long, unsigned int> &updated_nodes)
     // this function expand an LM tree given a new node in it, and record the nodes where the timestamp in the time_info map is updated with updated_nodes,
     {
@@ -496,44 +535,38 @@ private:
                 continue;
             }
 
-            std::map<long long, long long> aut_edge = aut.getAllSuccessors(tmp->state);
             // get the edges acceptable to the src state
-            //aut.get_all_suc(tmp->state, aut_edge); // get the edges acceptable to the src state
-            vector<sg_edge *> sucs = g.get_all_suc_ptrs(tmp->node_ID); // get out edges of the src node
-            for (auto &suc: sucs) {
-                unsigned int successor = suc->d;
-                unsigned int label = suc->label;
-                unsigned int time = min(tmp->timestamp, (unsigned int)suc->timestamp);
-                if (aut_edge.find(label) == aut_edge.end())
-                    continue;
-                long long dst_state = aut_edge[label];
-
-                if (lm_tree->get_time_info(successor, dst_state) >= time)
-                    // prune the branch if there is already a path with no smaller timestamp
-                    continue;
-                if (lm_tree->node_map.find(dst_state) == lm_tree->node_map.end() || lm_tree->node_map[dst_state]->index.
-                    find(successor) == lm_tree->node_map[dst_state]->index.end()) // if this node does not exist yet.
-                {
-                    tree_node *new_node = add_lm_node(lm_tree, successor, dst_state, lm_tree->root->node_ID,
-                                                      lm_tree->root->state, tmp, time, suc->timestamp);
-                    lm_tree->add_time_info(successor, dst_state, time);
-                    // add this new node and upadte the time info map
-                    updated_nodes[merge_long_long(successor, dst_state)] = time;
-                    q.push(new_node);
-                } else {
-                    tree_node *dst_pt = lm_tree->node_map[dst_state]->index[successor];
-                    if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
+            aut.forEachLabelFrom(tmp->state, [&](const long long label, const long long dst_state) {
+                g.for_each_successor(tmp->node_ID, label, [&](const neighbor &suc) { // visit the out edges of the src node with an acceptable label
+                    unsigned int successor = suc.vertex;
+                    unsigned int time = min(tmp->timestamp, (unsigned int)suc.timestamp);
+
+                    if (lm_tree->get_time_info(successor, dst_state) >= time)
+                        // prune the branch if there is already a path with no smaller timestamp
+                        return;
+                    if (tree_node *&dst_slot = lm_tree->node_slot(successor, dst_state); !dst_slot) // if this node does not exist yet.
                     {
-                        if (dst_pt->parent != tmp)
-                            lm_tree->substitute_parent(tmp, dst_pt);
-                        dst_pt->timestamp = time;
-                        dst_pt->edge_timestamp = suc->timestamp;
+                        tree_node *new_node = add_lm_node(lm_tree, successor, dst_state, lm_tree->root->node_ID,
+                                                          lm_tree->root->state, tmp, time, suc.timestamp, false, &dst_slot);
                         lm_tree->add_time_info(successor, dst_state, time);
+                        // add this new node and upadte the time info map
                         updated_nodes[merge_long_long(successor, dst_state)] = time;
-                        q.push(dst_pt);
+                        q.push(new_node);
+                    } else {
+                        tree_node *dst_pt = dst_slot;
+                        if (dst_pt->timestamp < time) // if the node exists but has a smaller timestamp
+                        {
+                            if (dst_pt->parent != tmp)
+                                lm_tree->substitute_parent(tmp, dst_pt);
+                            dst_pt->timestamp = time;
+                            dst_pt->edge_timestamp = suc.timestamp;
+                            lm_tree->add_time_info(successor, dst_state, time);
+                            updated_nodes[merge_long_long(successor, dst_state)] = time;
+                            q.push(dst_pt);
+                        }
                     }
-                }
-            }
+                });
+            });
         }
     }
 
@@ -550,9 +583,9 @@ private:
             auto iter = it->second->tree_index.find(lm); // find the list of LM trees containing this landmark.
             if (iter == it->second->tree_index.end())
                 return;
-            tree_info *cur = iter->second;
+            tree_info<N> *cur = iter->second;
             while (cur) {
-                RPQ_tree *tree_pt = cur->tree;
+                RPQ_tree<N> *tree_pt = cur->tree;
                 unsigned int root_ID = tree_pt->root->node_ID;
                 unsigned int root_state = tree_pt->root->state;
                 unsigned long long root_info = merge_long_long(root_ID, root_state);
@@ -562,10 +595,8 @@ private:
                     cur = cur->next;
                     continue;
                 }
-                assert(tree_pt->node_map.find(state) != tree_pt->node_map.end());
-                assert(tree_pt->node_map[state]->index.find(lm) != tree_pt->node_map[state]->index.end());
-
-                tree_node *lm_node = tree_pt->node_map[state]->index[lm];
+                tree_node *lm_node = tree_pt->find_node(lm, state);
+                assert(lm_node);
 
                 unordered_map<unsigned long long, unsigned int> tracked_nodes;
                 unsigned int local_src_time = min(lm_node->timestamp, src_time);
@@ -620,7 +651,7 @@ private:
 
 
     void insert_edge_lm_tree(unsigned int s, unsigned int d, unsigned int label, unsigned int timestamp, unsigned int src_state,
-                             unsigned int dst_state, RPQ_tree *lm_tree,
+                             unsigned int dst_state, RPQ_tree<N> *lm_tree,
                              unordered_map<unsigned long long, vector<pair<unsigned int, unsigned int> > > &lm_results)
     // insert a new edge (s, src_state) (d, dst_state) with label and timestamp in an LM tree,  record the final-state nodes to which the laste path timestamp has been updated in lm_results.
     {
@@ -629,9 +660,8 @@ private:
         unsigned long long root_info = merge_long_long(root_ID, root_state);
         if (lm_results.find(merge_long_long(root_ID, root_state)) != lm_results.end()) return;
         unordered_map<unsigned long long, unsigned int> updated_nodes;
-        assert(lm_tree->node_map.find(src_state) != lm_tree->node_map.end());
-        assert(lm_tree->node_map[src_state]->index.find(s) != lm_tree->node_map[src_state]->index.end());
-        tree_node *src_pt = lm_tree->node_map[src_state]->index[s];
+        tree_node *src_pt = lm_tree->find_node(s, src_state);
+        assert(src_pt);
         merge_long_long(s, src_state);
         merge_long_long(d, dst_state);
         if (src_pt->timestamp < lm_tree->get_time_info(s, src_state))
@@ -642,13 +672,12 @@ private:
             return;
 
         tree_node *dst_pt = nullptr;
-        if (lm_tree->node_map.find(dst_state) == lm_tree->node_map.end() || lm_tree->node_map[dst_state]->index.find(d)
-            == lm_tree->node_map[dst_state]->index.end()) // add the dst node if it is not in the tree yet.
+        if (tree_node *&dst_slot = lm_tree->node_slot(d, dst_state); !dst_slot) // add the dst node if it is not in the tree yet.
             dst_pt = add_lm_node(lm_tree, d, dst_state, lm_tree->root->node_ID, lm_tree->root->state, src_pt,
-                                 min(src_pt->timestamp, timestamp), timestamp);
+                                 min(src_pt->timestamp, timestamp), timestamp, false, &dst_slot);
         else {
             // else the new timestamp must be larger than the existing timestamp of dst node in this tree, otherwise we should have returned in the above check.
-            dst_pt = lm_tree->node_map[dst_state]->index[d];
+            dst_pt = dst_slot;
             if (dst_pt->timestamp < min(src_pt->timestamp, timestamp)) {
                 if (dst_pt->parent != src_pt)
                     lm_tree->substitute_parent(src_pt, dst_pt);
@@ -682,23 +711,21 @@ private:
         unsigned long long lm_info = merge_long_long(lm, state);
         if (forests.find(lm_info) == forests.end())
             return;
-        RPQ_tree *lm_tree = forests[lm_info];
+        RPQ_tree<N> *lm_tree = forests[lm_info];
         for (long long final_state: aut.finalStates) {
-            if (lm_tree->time_info.find(final_state) != lm_tree->time_info.end()) {
-                for (auto iter = lm_tree->time_info[final_state]->index.
-                             begin(); iter != lm_tree->time_info[final_state]->index.end(); iter++) {
-                    unsigned int v = iter->first;
-                    unsigned int time = min(lm_time, iter->second);
-                    if (updated_results.find(v) != updated_results.end())
-                        updated_results[v] = max(updated_results[v], time);
-                    else
-                        updated_results[v] = time;
-                }
+            for (auto iter = lm_tree->time_info[final_state].index.
+                         begin(); iter != lm_tree->time_info[final_state].index.end(); iter++) {
+                unsigned int v = iter->first;
+                unsigned int time = min(lm_time, iter->second);
+                if (updated_results.find(v) != updated_results.end())
+                    updated_results[v] = max(updated_results[v], time);
+                else
+                    updated_results[v] = time;
             }
         }
     }
 
-    void non_lm_expand(tree_node *expand_node, RPQ_tree *tree_pt)
+    void non_lm_expand(tree_node *expand_node, RPQ_tree<N> *tree_pt)
     // this function is used to expand a normal tree given a new node expand_node;
     {
         unordered_map<unsigned int, unsigned int> updated_results;
@@ -722,31 +749,28 @@ private:
                 // if this node is a landmark, we directly get the timestamp of its successors from the time info map.
                 continue;
             }
-            vector<sg_edge*> vec = g.get_all_suc_ptrs(tmp->node_ID); // get all the out edge of the src node
-            for (auto & i : vec) {
-                unsigned int successor = i->d;
-                unsigned int edge_label = i->label;
-                long long dst_state = aut.getNextState(tmp->state, edge_label); // check if we can travel to a dst state
-                if (dst_state == -1)
-                    continue;
-                unsigned int time = min(tmp->timestamp, (unsigned int)i->timestamp); // compute timestamp of the dst node
-                if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->
-                    index.find(successor) == tree_pt->node_map[dst_state]->index.end())
-                // add dst node to the tree if it does not exist
-                    q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time,
-                                    i->timestamp));
-                else {
-                    tree_node *dst_pt = tree_pt->node_map[dst_state]->index[successor];
-                    if (dst_pt->timestamp < time) {
-                        // if the timestamp of the new path is larger than the old node time, link dst node to the new path and update its timestamp
-                        if (dst_pt->parent != tmp)
-                            tree_pt->substitute_parent(tmp, dst_pt);
-                        dst_pt->timestamp = time;
-                        dst_pt->edge_timestamp = i->timestamp;
-                        q.push(dst_pt);
+            aut.forEachLabelFrom(tmp->state, [&](const long long edge_label, const long long dst_state) {
+                // visit the out edges of the src node that can travel to a dst state
+                g.for_each_successor(tmp->node_ID, edge_label, [&](const neighbor &i) {
+                    unsigned int successor = i.vertex;
+                    unsigned int time = min(tmp->timestamp, (unsigned int)i.timestamp); // compute timestamp of the dst node
+                    if (tree_node *&dst_slot = tree_pt->node_slot(successor, dst_state); !dst_slot)
+                    // add dst node to the tree if it does not exist
+                        q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time,
+                                        i.timestamp, false, &dst_slot));
+                    else {
+                        tree_node *dst_pt = dst_slot;
+                        if (dst_pt->timestamp < time) {
+                            // if the timestamp of the new path is larger than the old node time, link dst node to the new path and update its timestamp
+                            if (dst_pt->parent != tmp)
+                                tree_pt->substitute_parent(tmp, dst_pt);
+                            dst_pt->timestamp = time;
+                            dst_pt->edge_timestamp = i.timestamp;
+                            q.push(dst_pt);
+                        }
                     }
-                }
-            }
+                });
+            });
         }
         update_result(updated_results, tree_pt->root->node_ID);
         // update the result set with the collected final-state nodes
@@ -755,7 +779,7 @@ private:
 
     void visit_non_lm_tree(unsigned int s, unsigned int d, unsigned int label, unsigned int timestamp, unsigned int src_state,
                            unsigned int dst_state,
-                           RPQ_tree *tree_pt,
+                           RPQ_tree<N> *tree_pt,
                            unordered_map<unsigned long long, vector<pair<unsigned int, unsigned int> > > &lm_results,
                            unordered_set<unsigned int> &visited) {
         // this function is used to update normal trees. normal trees are updated in 2 cases: it containing the src node of the new edge, or it is found in the backward search of a lm tree
@@ -777,7 +801,7 @@ private:
         // and record the largest timestamp, which is the largest timestamp of paths to the src/ dst node passing landmarks.
         {
             if (unsigned long long lm_info = *iter; forests.find(lm_info) != forests.end()) {
-                RPQ_tree *lm_tree = forests[lm_info];
+                RPQ_tree<N> *lm_tree = forests[lm_info];
                 tree_node *lm_node = tree_pt->find_node((lm_info >> 32), (lm_info & 0xFFFFFFFF));
                 unsigned int local_src_time = lm_tree->get_time_info(s, src_state);
                 if (min(local_src_time, lm_node->timestamp) > max_src_time) {
@@ -791,32 +815,28 @@ private:
             }
         }
 
-        if (tree_pt->node_map.find(src_state) != tree_pt->node_map.end()) // if the normal tree contians the src node
-        {
-            if (tree_node_index *tmp_index = tree_pt->node_map[src_state]; tmp_index->index.find(s) != tmp_index->index.end()) {
-                if (tree_node *src_pt = tmp_index->index[s]; !src_pt->lm && src_pt->timestamp > max_src_time && min(src_pt->timestamp, timestamp) > max_dst_time)
-                // we expand this normal tree only if the local path has larger timestamp than the paths passing landmarks
-                // and no exisiting path has larger, or equal timestamp than the new local path to the dst node
-                {
-                    unsigned int time = min(src_pt->timestamp, timestamp);
-                    if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->
-                        index.find(d) == tree_pt->node_map[dst_state]->index.end()) {
-                        // need to be checked
-                        tree_node *dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt,
-                                                     min(src_pt->timestamp, timestamp), timestamp);
+        if (tree_node *src_pt = tree_pt->find_node(s, src_state)) {
+            if (!src_pt->lm && src_pt->timestamp > max_src_time && min(src_pt->timestamp, timestamp) > max_dst_time)
+            // we expand this normal tree only if the local path has larger timestamp than the paths passing landmarks
+            // and no exisiting path has larger, or equal timestamp than the new local path to the dst node
+            {
+                unsigned int time = min(src_pt->timestamp, timestamp);
+                if (tree_node *&dst_slot = tree_pt->node_slot(d, dst_state); !dst_slot) {
+                    // need to be checked
+                    tree_node *dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt,
+                                                 min(src_pt->timestamp, timestamp), timestamp, false, &dst_slot);
+                    non_lm_expand(dst_pt, tree_pt);
+                } else {
+                    tree_node *dst_pt = dst_slot;
+                    if (dst_pt->timestamp < time) {
+                        if (dst_pt->parent != src_pt)
+                            tree_pt->substitute_parent(src_pt, dst_pt);
+                        dst_pt->timestamp = time;
+                        dst_pt->edge_timestamp = timestamp;
                         non_lm_expand(dst_pt, tree_pt);
-                    } else {
-                        tree_node *dst_pt = tree_pt->node_map[dst_state]->index[d];
-                        if (dst_pt->timestamp < time) {
-                            if (dst_pt->parent != src_pt)
-                                tree_pt->substitute_parent(src_pt, dst_pt);
-                            dst_pt->timestamp = time;
-                            dst_pt->edge_timestamp = timestamp;
-                            non_lm_expand(dst_pt, tree_pt);
-                        }
                     }
-                    return;
                 }
+                return;
             }
         }
 
@@ -828,11 +848,11 @@ private:
             unsigned int lm_ID = max_src_lm >> 32;
             unsigned int lm_state = (max_src_lm & 0xFFFFFFFF);
             update_result(lm_results[max_src_lm], tree_pt->root->node_ID,
-                          tree_pt->node_map[lm_state]->index[lm_ID]->timestamp);
+                          tree_pt->find_node(lm_ID, lm_state)->timestamp);
         }
     }
 
-    void expand_in_recover(tree_node *expand_node, RPQ_tree *tree_pt, RPQ_tree *lm_tree, bool lm_expand_tree = false)
+    void expand_in_recover(tree_node *expand_node, RPQ_tree<N> *tree_pt, RPQ_tree<N> *lm_tree, bool lm_expand_tree = false)
     // this is the function to expand a tree when recovering
     // the subtree of a eliminated landmark. tree_pt is the tree in which we recover the subtree, lm_expand_tree indicating if it is an LM tree. lm_tree is the pointer to the LM tree of the eliminated landmark
     // we carry out expand following this LM tree rather than traverse the graph.
@@ -862,21 +882,20 @@ private:
                 unsigned int state = child->state;
                 unsigned int time = min(child->edge_timestamp, expand_tree_node->timestamp);
                 // compute the timestamp of this child in tree_pt
-                if (tree_pt->node_map.find(state) == tree_pt->node_map.end() || tree_pt->node_map[state]->index.find(v)
-                    == tree_pt->node_map[state]->index.end()) {
+                if (tree_node *&slot = tree_pt->node_slot(v, state); !slot) {
                     tree_node *new_node = nullptr; // if it does not exist, we add this node
                     if (lm_expand_tree) {
                         new_node = add_lm_node(tree_pt, v, state, tree_pt->root->node_ID, tree_pt->root->state,
-                                               expand_tree_node, time, child->edge_timestamp);
+                                               expand_tree_node, time, child->edge_timestamp, false, &slot);
                         if (tree_pt->get_time_info(v, state) < time)
                             // in fact I suppose this will not happen, as no new path will be build in recovering subtree, still check it to make sure.
                             tree_pt->add_time_info(v, state, time);
                     } else
                         new_node = add_node(tree_pt, v, state, tree_pt->root->node_ID, expand_tree_node, time,
-                                            child->edge_timestamp);
+                                            child->edge_timestamp, false, &slot);
                     q.emplace(new_node, child);
                 } else {
-                    tree_node *new_node = tree_pt->node_map[state]->index[v];
+                    tree_node *new_node = slot;
                     // of the node exists, we update its timestamp.
                     if (new_node->timestamp < time) {
                         if (new_node->parent != expand_tree_node)
@@ -898,16 +917,12 @@ private:
         }
     }
 
-    void generate_time_info(RPQ_tree *tree_pt)
+    void generate_time_info(RPQ_tree<N> *tree_pt)
     // this function is used to generate time info map for new LM trees. Time info map is generated as a union of nodes in this LM tree, and the time info map of the landmarks in it.
     {
-        for (auto iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++) {
-            unsigned int state = iter->first;
-            if (tree_pt->time_info.find(state) == tree_pt->time_info.end())
-                tree_pt->time_info[state] = new time_info_index;
-            for (auto &[fst, snd] : iter->second->index)
-                tree_pt->time_info[state]->index[fst] = snd->timestamp;
-        }
+        tree_pt->node_map.for_each([&](const tree_node *node) {
+            tree_pt->add_time_info(node->node_ID, node->state, node->timestamp);
+        });
         for (auto set_iter = tree_pt->landmarks.begin(); set_iter != tree_pt->landmarks.end(); set_iter++) {
             unsigned long long lm_info = *set_iter;
             unsigned int lm_ID = (lm_info >> 32);
@@ -915,56 +930,50 @@ private:
             tree_node *lm_node = tree_pt->find_node(lm_ID, lm_state);
             unsigned int lm_time = lm_node->timestamp;
             if (forests.find(lm_info) != forests.end()) {
-                RPQ_tree *lm_tree = forests[lm_info];
-                for (auto &[fst, snd] : lm_tree->time_info) {
-                    unsigned int state = fst;
-                    if (tree_pt->time_info.find(state) == tree_pt->time_info.end())
-                        tree_pt->time_info[state] = new time_info_index;
-                    for (auto info_iter = snd->index.begin(); info_iter != snd->index.end(); info_iter++)
-                        tree_pt->time_info[state]->index[info_iter->first] = max(tree_pt->time_info[state]->index[info_iter->first], min(info_iter->second, lm_time));
+                RPQ_tree<N> *lm_tree = forests[lm_info];
+                for (unsigned int state = 0; state < lm_tree->time_info.size(); state++) {
+                    const time_info_index &lm_index = lm_tree->time_info[state];
+                    for (auto info_iter = lm_index.index.begin(); info_iter != lm_index.index.end(); info_iter++)
+                        tree_pt->raise_time_info(info_iter->first, state, min(info_iter->second, lm_time));
                 }
             }
         }
     }
 
-    void switch_tree_index(RPQ_tree *tree_pt)
+    void switch_tree_index(RPQ_tree<N> *tree_pt)
     // this function switch the reverse index of nodes in tree_pt from v2t_index to v2l_index, used when tree_pt is transformed into an LM tree.
     {
         unsigned int root_ID = tree_pt->root->node_ID;
         unsigned int root_state = tree_pt->root->state;
-        for (auto iter = tree_pt->node_map.begin();iter != tree_pt->node_map.end(); iter++) {
-            for (auto &[fst, snd] : iter->second->index) {
-                delete_index(fst, snd->state, root_ID);
-                add_lm_index(tree_pt, fst, snd->state, root_ID, root_state);
-            }
-        }
+        tree_pt->node_map.for_each([&](const tree_node *node) {
+            delete_index(node->node_ID, node->state, root_ID);
+            add_lm_index(tree_pt, node->node_ID, node->state, root_ID, root_state);
+        });
     }
 
-    void switch_tree_index_reverse(RPQ_tree *tree_pt)
+    void switch_tree_index_reverse(RPQ_tree<N> *tree_pt)
     // this function switch the reverse index of nodes in tree_pt from v2l_index to v2t_index, used when tree_pt is transformed from an LM tree to a normal tree.
     {
         unsigned int root_ID = tree_pt->root->node_ID;
         unsigned int root_state = tree_pt->root->state;
-        for (auto iter = tree_pt->node_map.begin(); iter != tree_pt->node_map.end(); iter++) {
-            for (auto & iter2 : iter->second->index) {
-                delete_lm_index(iter2.first, iter2.second->state, root_ID, root_state);
-                add_index(tree_pt, iter2.first, iter2.second->state, root_ID);
-            }
-        }
+        tree_pt->node_map.for_each([&](const tree_node *node) {
+            delete_lm_index(node->node_ID, node->state, root_ID, root_state);
+            add_index(tree_pt, node->node_ID, node->state, root_ID);
+        });
     }
 
-    void recover_subtree(unsigned int v, unsigned int state, RPQ_tree *lm_tree)
+    void recover_subtree(unsigned int v, unsigned int state, RPQ_tree<N> *lm_tree)
     // this function recovers the subtrees of a deleted landmark (v, state) in normal trees, lm_tree is the LM tree of this landmark.
     {
         auto iter = v2t_index.find(state);
         if (iter != v2t_index.end()) {
             auto tree_iter = iter->second->tree_index.find(v);
             if (tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
+                    touch_tree(tree_pt);
                     tree_pt->landmarks.erase(merge_long_long(v, state));
-                    shrink(tree_pt->landmarks);
                     tree_node *lm_node = tree_pt->find_node(v, state);
                     lm_node->lm = false;
                     if (lm_tree) {
@@ -994,18 +1003,18 @@ private:
         }
     }
 
-    void recover_subtree_lm(unsigned int v, unsigned int state, RPQ_tree *lm_tree)
+    void recover_subtree_lm(unsigned int v, unsigned int state, RPQ_tree<N> *lm_tree)
     // this function recovers the subtrees of a deleted landmark (v, state) in other LM trees, lm_tree is the LM tree of this landmark.
     {
         auto iter = v2l_index.find(state);
         if (iter != v2l_index.end()) {
             auto tree_iter = iter->second->tree_index.find(v);
             if (tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
+                    touch_tree(tree_pt);
                     tree_pt->landmarks.erase(merge_long_long(v, state));
-                    shrink(tree_pt->landmarks);
                     tree_node *lm_node = tree_pt->find_node(v, state);
                     lm_node->lm = false;
                     if (lm_tree) {
@@ -1029,9 +1038,10 @@ private:
         if (iter != v2t_index.end()) {
             auto tree_iter = iter->second->tree_index.find(v);
             if (tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
+                    touch_tree(tree_pt);
                     tree_pt->landmarks.insert(merge_long_long(v, state));
                     // add the new landmark to the landmark set of the normal tree
                     tree_node *lm_node = tree_pt->find_node(v, state);
@@ -1053,16 +1063,9 @@ private:
                             q.push(child);
                             child = child->brother;
                         }
-                        assert(tree_pt->node_map.find(cur->state) != tree_pt->node_map.end());
-                        tree_pt->node_map[cur->state]->index.erase(cur->node_ID);
-                        shrink(tree_pt->node_map[cur->state]->index);
-                        if (tree_pt->node_map[cur->state]->index.empty()) {
-                            delete tree_pt->node_map[cur->state];
-                            tree_pt->node_map.erase(cur->state);
-                        }
+                        tree_pt->node_map.erase(merge_long_long(cur->node_ID, cur->state));
                         if (cur->lm) {
                             tree_pt->landmarks.erase(merge_long_long(cur->node_ID, cur->state));
-                            shrink(tree_pt->landmarks);
                         }
                         delete cur;
                         tree_pt->node_cnt--;
@@ -1073,7 +1076,7 @@ private:
         }
     }
 
-    void retrieve_subtree_lm(unsigned int v, unsigned int state, RPQ_tree *lm_tree,
+    void retrieve_subtree_lm(unsigned int v, unsigned int state, RPQ_tree<N> *lm_tree,
                              unordered_set<unsigned long long> &necessary_nodes)
     // this function delete the subtree of a landmark (v, state) in LM trees.
     // note that there are some "sensitive " nodes which may be missed in the LM tree of (v, state), we need to compare the LM tree of (v, state) (lm_tree) with each subtree to find these nodes, and add them into
@@ -1083,14 +1086,15 @@ private:
         if (iter != v2l_index.end()) {
             auto tree_iter = iter->second->tree_index.find(v);
             if (tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
                     if (tree_pt->root->node_ID == v && tree_pt->root->state == state) // we need to skip lm_tree itself;
                     {
                         tmp = tmp->next;
                         continue;
                     }
+                    touch_tree(tree_pt);
                     tree_pt->landmarks.insert(merge_long_long(v, state));
                     tree_node *lm_node = tree_pt->find_node(v, state);
                     lm_node->lm = true;
@@ -1138,15 +1142,9 @@ private:
                     }
                     for (auto & i : vec) {
                         delete_lm_index(i->node_ID, i->state, tree_pt->root->node_ID, tree_pt->root->state);
-                        tree_pt->node_map[i->state]->index.erase(i->node_ID);
-                        shrink(tree_pt->node_map[i->state]->index);
-                        if (tree_pt->node_map[i->state]->index.empty()) {
-                            delete tree_pt->node_map[i->state];
-                            tree_pt->node_map.erase(i->state);
-                        }
+                        tree_pt->node_map.erase(merge_long_long(i->node_ID, i->state));
                         if (i->lm) {
                             tree_pt->landmarks.erase(merge_long_long(i->node_ID, i->state));
-                            shrink(tree_pt->landmarks);
                         }
                         delete i;
                         tree_pt->node_cnt--;
@@ -1157,16 +1155,14 @@ private:
         }
     }
 
-    void fulfill_new_lm_tree(RPQ_tree *tree_pt, unordered_set<unsigned long long> necessary_nodes)
+    void fulfill_new_lm_tree(RPQ_tree<N> *tree_pt, unordered_set<unsigned long long> necessary_nodes)
     // this function add necessary nodes to a new LM tree. these nodes are in paths which are latest but not in the LM tree, they are pruned because there is already a path with the same timestamp passing
     // other landmarks. However, due to existence of circles, these paths may be in the subtree of the new landmark, and once the subtree is deleted, these paths are missed. thus we need to add them back in
     // the LM tree. Details about how these nodes are missed can be found in the technical report
     {
         vector<tree_node *> original_vec;
-        for (auto &[fst, snd] : tree_pt->node_map) {
-            for (auto &[fst1, snd1] : snd->index)
-                original_vec.push_back(snd1);
-        }
+        original_vec.reserve(tree_pt->node_map.size());
+        tree_pt->node_map.for_each([&](tree_node *node) { original_vec.push_back(node); });
 
         for (auto cur : original_vec)
         // we scan the nodes already in the lm tree one by one, try to expand them to add the necessary nodes.
@@ -1180,37 +1176,37 @@ private:
                     tree_pt->landmarks.insert(merge_long_long(cur->node_ID, cur->state));
                     continue;
                 }
-                vector<sg_edge*> vec = g.get_all_suc_ptrs(cur->node_ID);
-                for (auto & j : vec) {
-                    unsigned int successor = j->d;
-                    long long dst_state = aut.getNextState(cur->state, j->label);
-                    if (dst_state == -1) continue;
-                    unsigned int time = min(cur->timestamp, (unsigned int)j->timestamp);
-                    if (necessary_nodes.find(merge_long_long(successor, dst_state)) == necessary_nodes.end() && tree_pt->get_time_info(successor, dst_state) > time)
-                        // we prune a branch if it is not a necessary nodes and the path to it is not the latest.
-                        continue;
-                    if (tree_pt->node_map.find(dst_state) != tree_pt->node_map.end() && tree_pt->node_map[dst_state]->index.find(successor) != tree_pt->node_map[dst_state]->index.end()) {
-                        tree_node *suc_pt = tree_pt->node_map[dst_state]->index[successor];
-                        if (suc_pt->timestamp < time) {
-                            if (suc_pt->parent != cur)
-                                tree_pt->substitute_parent(cur, suc_pt);
-                            suc_pt->edge_timestamp = j->timestamp;
-                            suc_pt->timestamp = time;
+                aut.forEachLabelFrom(cur->state, [&](const long long label, const long long dst_state) {
+                    g.for_each_successor(cur->node_ID, label, [&](const neighbor &j) {
+                        unsigned int successor = j.vertex;
+                        unsigned int time = min(cur->timestamp, (unsigned int)j.timestamp);
+                        if (necessary_nodes.find(merge_long_long(successor, dst_state)) == necessary_nodes.end() && tree_pt->get_time_info(successor, dst_state) > time)
+                            // we prune a branch if it is not a necessary nodes and the path to it is not the latest.
+                            return;
+                        if (tree_node *&suc_slot = tree_pt->node_slot(successor, dst_state)) {
+                            tree_node *suc_pt = suc_slot;
+                            if (suc_pt->timestamp < time) {
+                                if (suc_pt->parent != cur)
+                                    tree_pt->substitute_parent(cur, suc_pt);
+                                suc_pt->edge_timestamp = j.timestamp;
+                                suc_pt->timestamp = time;
+                                q.push(suc_pt);
+                            }
+                        } else {
+                            tree_node *suc_pt = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, cur, time, j.timestamp, landmarks.find(merge_long_long(successor, dst_state)) != landmarks.end(), &suc_slot);
                             q.push(suc_pt);
                         }
-                    } else {
-                        tree_node *suc_pt = add_lm_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tree_pt->root->state, cur, time, j->timestamp, landmarks.find(merge_long_long(successor, dst_state)) != landmarks.end());
-                        q.push(suc_pt);
-                    }
-                }
+                    });
+                });
             }
         }
     }
 
-    RPQ_tree *build_lm_tree(unsigned int v, unsigned int state)
+    RPQ_tree<N> *build_lm_tree(unsigned int v, unsigned int state)
     // this function build new lm tree for a landmark, we use time info in prune and may miss some nodes, we will add them back with above fulfill_new_lm_tree later .
     {
-        auto *new_tree = new RPQ_tree;
+        auto *new_tree = new RPQ_tree<N>(aut.states());
+        new_tree->count_time_info(&ti_refs);
         new_tree->root = new_tree->add_node(v, state, nullptr, MAX_INT, MAX_INT);
         new_tree->add_time_info(v, state, MAX_INT);
         queue<tree_node *> q;
@@ -1228,42 +1224,37 @@ private:
                 continue;
             }
 
-            map<long long, long long> aut_edge = aut.getAllSuccessors(tmp->state);
-            vector<sg_edge*> sucs = g.get_all_suc_ptrs(tmp->node_ID);
-            for (auto & suc : sucs) {
-                unsigned int successor = suc->d;
-                unsigned int label = suc->label;
-                unsigned int time = min(tmp->timestamp, (unsigned int)suc->timestamp);
-                if (aut_edge.find(label) == aut_edge.end())
-                    continue;
-                long long dst_state = aut_edge[label];
+            aut.forEachLabelFrom(tmp->state, [&](const long long label, const long long dst_state) {
+                g.for_each_successor(tmp->node_ID, label, [&](const neighbor &suc) { // visit the out edges of the src node with an acceptable label
+                    unsigned int successor = suc.vertex;
+                    unsigned int time = min(tmp->timestamp, (unsigned int)suc.timestamp);
 
-                if (new_tree->get_time_info(successor, dst_state) >= time)
-                    // we pruen the branch once there is already a path with no smaller timestamp. this may lead to some nodes missing. they will be added back later in fulfill_new_lm tree.
-                    continue;
+                    if (new_tree->get_time_info(successor, dst_state) >= time)
+                        // we pruen the branch once there is already a path with no smaller timestamp. this may lead to some nodes missing. they will be added back later in fulfill_new_lm tree.
+                        return;
 
-                if (new_tree->node_map.find(dst_state) == new_tree->node_map.end() || new_tree->node_map[dst_state]->
-                    index.find(successor) == new_tree->node_map[dst_state]->index.end()) {
-                    tree_node *new_node = new_tree->add_node(successor, dst_state, tmp, time, suc->timestamp);
-                    new_tree->add_time_info(successor, dst_state, time);
-                    q.push(new_node);
-                } else {
-                    tree_node *dst_pt = new_tree->node_map[dst_state]->index[successor];
-                    if (dst_pt->timestamp < time) {
-                        if (dst_pt->parent != tmp)
-                            new_tree->substitute_parent(tmp, dst_pt);
-                        dst_pt->timestamp = time;
-                        dst_pt->edge_timestamp = suc->timestamp;
+                    if (tree_node *&dst_slot = new_tree->node_slot(successor, dst_state); !dst_slot) {
+                        tree_node *new_node = new_tree->add_node(successor, dst_state, tmp, time, suc.timestamp, &dst_slot);
                         new_tree->add_time_info(successor, dst_state, time);
-                        q.push(dst_pt);
+                        q.push(new_node);
+                    } else {
+                        tree_node *dst_pt = dst_slot;
+                        if (dst_pt->timestamp < time) {
+                            if (dst_pt->parent != tmp)
+                                new_tree->substitute_parent(tmp, dst_pt);
+                            dst_pt->timestamp = time;
+                            dst_pt->edge_timestamp = suc.timestamp;
+                            new_tree->add_time_info(successor, dst_state, time);
+                            q.push(dst_pt);
+                        }
                     }
-                }
-            }
+                });
+            });
         }
         return new_tree;
     }
 
-    void build_v2l_index(RPQ_tree *new_tree)
+    void build_v2l_index(RPQ_tree<N> *new_tree)
     // this function build the reverse index given a new LM tree, we do not build the reverse index during LM tree building, as the LM tree may not become valid.
     {
         queue<tree_node *> q;
@@ -1285,9 +1276,9 @@ private:
     {
         unsigned int sum = 0;
         if (v2t_index.find(state) != v2t_index.end()) {
-            tree_info_index *index = v2t_index[state];
+            tree_info_index<N> *index = v2t_index[state];
             if (index->tree_index.find(id) != index->tree_index.end()) {
-                tree_info *tmp = index->tree_index[id];
+                tree_info<N> *tmp = index->tree_index[id];
                 while (tmp) {
                     sum++;
                     if (sum >= threshold)
@@ -1297,9 +1288,9 @@ private:
             }
         }
         if (v2l_index.find(state) != v2l_index.end()) {
-            lm_info_index *index = v2l_index[state];
+            lm_info_index<N> *index = v2l_index[state];
             if (index->tree_index.find(id) != index->tree_index.end()) {
-                tree_info *tmp = index->tree_index[id];
+                tree_info<N> *tmp = index->tree_index[id];
                 while (tmp) {
                     sum++;
                     if (sum >= threshold)
@@ -1312,7 +1303,7 @@ private:
     }
 
 
-    double recover_subtree_preview(unsigned int v, unsigned int state, RPQ_tree *lm_tree, double node_budget)
+    double recover_subtree_preview(unsigned int v, unsigned int state, RPQ_tree<N> *lm_tree, double node_budget)
     // this function predicts the number of nodes we need to add back in normal trees once we delete a landmark from the landmark set.
     // if the number of nodes exceeds the node_budget, we stop the counting and return. lm_tree is the LM tree of the landmark we try to delete.
     {
@@ -1320,18 +1311,16 @@ private:
         if (auto iter = v2t_index.find(state); iter != v2t_index.end()) {
             auto tree_iter = iter->second->tree_index.find(v);
             if (tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
-                    for (auto &[fst, snd] : lm_tree->node_map) {
-                        for (auto & node_iter2 : snd->index) {
-                            if (tree_pt->find_node(node_iter2.first, fst) == nullptr) {
-                                node_budget--;
-                                // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to
-                                // the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
-                            }
+                    RPQ_tree<N> *tree_pt = tmp->tree;
+                    lm_tree->node_map.for_each([&](const tree_node *node) {
+                        if (tree_pt->find_node(node->node_ID, node->state) == nullptr) {
+                            node_budget--;
+                            // the number of nodes is predicted as the number of nodes in the lm_tree but not in the normal tree, in this prediction we do not bother to check if the local path to
+                            // the landmark is latest, as it needs considerabel computation in normal trees. As a result the prediction will be larger than the fact.
                         }
-                    }
+                    });
                     if (node_budget <= 0)
                         return 0;
                     tmp = tmp->next;
@@ -1341,16 +1330,16 @@ private:
         return node_budget;
     }
 
-    double recover_subtree_lm_preview(unsigned int v, unsigned int state, RPQ_tree *lm_tree, double node_budget)
+    double recover_subtree_lm_preview(unsigned int v, unsigned int state, RPQ_tree<N> *lm_tree, double node_budget)
     // this function predicts the number of nodes we need to add back in LM trees once we delete a landmark from the landmark set.
     // if the number of nodes exceeds the node_budget, we stop the counting and return. lm_tree is the LM tree of the landmark we try to delete.
     {
         unsigned int node_cnt = 0;
         if (auto iter = v2l_index.find(state); iter != v2l_index.end()) {
             if (auto tree_iter = iter->second->tree_index.find(v); tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
                     if (tree_pt->root->node_ID == v && tree_pt->root->state == state) // skip lm_tree itself.
                     {
                         tmp = tmp->next;
@@ -1360,13 +1349,11 @@ private:
                     if (tree_pt->get_time_info(v, state) == lm_node->timestamp)
                     // in LM tree we will check if the local path to the landmark is latest, as it costs little.
                     {
-                        for (auto &[fst, snd] : lm_tree->node_map) {
-                            for (auto &[fst1, snd2] : snd->index) {
-                                if (tree_pt->find_node(fst1, fst) == nullptr) {
-                                    node_budget--;
-                                }
+                        lm_tree->node_map.for_each([&](const tree_node *node) {
+                            if (tree_pt->find_node(node->node_ID, node->state) == nullptr) {
+                                node_budget--;
                             }
-                        }
+                        });
                     }
                     if (node_budget <= 0)
                         return 0;
@@ -1383,9 +1370,9 @@ private:
         unsigned int node_cnt = 0;
         if (auto iter = v2t_index.find(state); iter != v2t_index.end()) {
             if (auto tree_iter = iter->second->tree_index.find(v); tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
                     if (tree_pt->root->node_ID == v && tree_pt->root->state == state)
                     // skip the normal tree of (v, state) itself. As (v, state) is not a landmark yet, there may be a normal tree rooted at it if state = 0;
                     {
@@ -1419,9 +1406,9 @@ private:
         unsigned int node_cnt = 0;
         if (auto iter2 = v2l_index.find(state); iter2 != v2l_index.end()) {
             if (auto tree_iter = iter2->second->tree_index.find(v); tree_iter != iter2->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
                     tree_node *lm_node = tree_pt->find_node(v, state);
                     queue<tree_node *> q;
                     q.push(lm_node);
@@ -1443,7 +1430,7 @@ private:
         return node_cnt;
     }
 
-    void delete_v2h_index(RPQ_tree *tree_pt) // this function delete the reverse index of nodes in a LM tree.
+    void delete_v2h_index(RPQ_tree<N> *tree_pt) // this function delete the reverse index of nodes in a LM tree.
     {
         queue<tree_node *> q;
         q.push(tree_pt->root);
@@ -1459,9 +1446,16 @@ private:
 
 
 
-    void erase_tree_node(RPQ_tree *tree_pt, tree_node *child)
+    void touch_tree(const RPQ_tree<N> *tree_pt)
+    // record a tree that loses nodes, landmarks or TI map entries, so that the next compact() shrinks its tables.
+    {
+        touched_trees.insert(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state));
+    }
+
+    void erase_tree_node(RPQ_tree<N> *tree_pt, tree_node *child)
     // this function deletes subtree rooted at the given node (child) in a normal tree (tree_pt)
     {
+        touch_tree(tree_pt);
         queue<tree_node *> q;
         q.push(child);
         tree_pt->separate_node(child);
@@ -1477,10 +1471,11 @@ private:
         }
     }
 
-    void erase_lm_tree_node(RPQ_tree *tree_pt, tree_node *child, vector<unsigned long long> &deleted)
+    void erase_lm_tree_node(RPQ_tree<N> *tree_pt, tree_node *child, vector<unsigned long long> &deleted)
     // this function deletes subtree rooted at the given node (child) in an LM tree (tree_pt), different from above,
     // we need to record the deleted nodes with a vectore deleted, we will use these nodes in a backward search later to delete time info map in precursors of this LM tree in the dependency graph.
     {
+        touch_tree(tree_pt);
         queue<tree_node *> q;
         q.push(child);
         tree_pt->separate_node(child);
@@ -1505,31 +1500,22 @@ private:
     {
         if (auto iter = v2l_index.find(state); iter != v2l_index.end()) {
             if (auto tree_iter = iter->second->tree_index.find(v); tree_iter != iter->second->tree_index.end()) {
-                tree_info *tmp = tree_iter->second;
+                tree_info<N> *tmp = tree_iter->second;
                 while (tmp) {
-                    RPQ_tree *tree_pt = tmp->tree;
+                    RPQ_tree<N> *tree_pt = tmp->tree;
                     unsigned long long tree_info = merge_long_long(tree_pt->root->node_ID, tree_pt->root->state);
                     if (visited.find(tree_info) != visited.end()) {
                         tmp = tmp->next;
                         continue;
                     }
                     visited.insert(tree_info);
+                    touched_trees.insert(tree_info);
                     vector<unsigned long long> tracked_nodes;
                     for (unsigned long long dst_info : deleted_results) {
                         unsigned int dst_state = (dst_info & 0xFFFFFFFF);
                         unsigned int dst_ID = (dst_info >> 32);
-                        if (tree_pt->time_info.find(dst_state) != tree_pt->time_info.end()) {
-                            if (tree_pt->time_info[dst_state]->index.find(dst_ID) != tree_pt->time_info[dst_state]->
-                                index.end()) {
-                                if (tree_pt->time_info[dst_state]->index[dst_ID] < expired_time) {
-                                    // check if the time info entry of a node is expired.
-                                    tree_pt->time_info[dst_state]->index.erase(dst_ID);
-                                    shrink(tree_pt->time_info[dst_state]->index);
-                                }
-                                if (tree_pt->time_info[dst_state]->index.empty())
-                                    tree_pt->time_info.erase(dst_state);
-                            }
-                        }
+                        tree_pt->expire_time_info(dst_ID, dst_state, expired_time);
+                        // check if the time info entry of a node is expired.
                         tracked_nodes.push_back(dst_info);
                         // it should be noted that we need to futher backtrack up with all nodes in deleted_results, otherwise errors will happen, some expired time info entries will be left
                         // this is caused by circles in the depdency graph.
@@ -1544,83 +1530,58 @@ private:
         }
     }
 
-    void expire_per_lm_tree(unsigned int v, unsigned int state, RPQ_tree *tree_pt, unsigned int expired_time)
+    void expire_per_lm_tree(unsigned int v, unsigned int state, RPQ_tree<N> *tree_pt, unsigned int expired_time)
     // carry out expiration in an LM tree tree_pt given a possibly expired node (v, state) and tail of sliding window expired_time.
     {
-        if (tree_pt->node_map.find(state) != tree_pt->node_map.end()) {
-            if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-                if (tree_node *dst_pt = tree_pt->node_map[state]->index[v]; dst_pt->timestamp < expired_time) {
-                    // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
-                    vector<unsigned long long> erased;
-                    vector<unsigned long long> deleted;
-                    unordered_set<unsigned long long> visited;
-                    erase_lm_tree_node(tree_pt, dst_pt, erased);
-                    if (!erased.empty()) {
-                        for (unsigned long long dst_info : erased) {
-                            if (landmarks.find(dst_info) != landmarks.end())
-                            // if a landmark is deleted, we need to check if it will influence the time info map
-                            {
-                                if (forests.find(dst_info) != forests.end()) {
-                                    RPQ_tree *dst_tree = forests[dst_info];
-                                    for (auto & dst_iter : dst_tree->time_info) {
-                                        unsigned int k = dst_iter.first;
-                                        if (tree_pt->time_info.find(k) == tree_pt->time_info.end())
-                                            continue;
-                                        time_info_index *target_index = tree_pt->time_info[k];
-                                        // scan the time info in the LM tree of the deleted landmark, as the paths to nodes in this time info map passing the deleted landmark expire, time info of these nodes
-                                        // in tree_pt may also expire, we need to check, and record the expired ones.
-                                        for (auto time_iter = dst_iter.second->index.begin(); time_iter != dst_iter.second->index.end(); time_iter++) {
-                                            if (target_index->index.find(time_iter->first) != target_index->index.end()) {
-                                                if (target_index->index[time_iter->first] < expired_time) {
-                                                    target_index->index.erase(time_iter->first);
-                                                    deleted.push_back(merge_long_long(time_iter->first, k));
-                                                }
-                                            }
-                                        }
-                                        shrink(target_index->index);
-                                        if (target_index->index.empty())
-                                            tree_pt->time_info.erase(k);
-                                    }
-                                }
-                            }
-                            unsigned int dst_ID = (dst_info >> 32);
-                            unsigned int dst_state = (dst_info & 0xFFFFFFFF);
-                            if (tree_pt->time_info.find(dst_state) != tree_pt->time_info.end()) {
-                                // check time info of this deleted node.
-                                if (tree_pt->time_info[dst_state]->index.find(dst_ID) != tree_pt->time_info[dst_state]->
-                                    index.end()) {
-                                    if (tree_pt->time_info[dst_state]->index[dst_ID] < expired_time) {
-                                        tree_pt->time_info[dst_state]->index.erase(dst_ID);
-                                        shrink(tree_pt->time_info[dst_state]->index);
-                                        if (tree_pt->time_info[dst_state]->index.empty())
-                                            tree_pt->time_info.erase(dst_state);
-                                        deleted.push_back(dst_info);
+        if (tree_node *dst_pt = tree_pt->find_node(v, state)) {
+            if (dst_pt->timestamp < expired_time) {
+                // if this node indeex expireds, we need to erase its subtree and carry out expire_backtrack
+                vector<unsigned long long> erased;
+                vector<unsigned long long> deleted;
+                unordered_set<unsigned long long> visited;
+                erase_lm_tree_node(tree_pt, dst_pt, erased);
+                if (!erased.empty()) {
+                    for (unsigned long long dst_info : erased) {
+                        if (landmarks.find(dst_info) != landmarks.end())
+                        // if a landmark is deleted, we need to check if it will influence the time info map
+                        {
+                            if (forests.find(dst_info) != forests.end()) {
+                                RPQ_tree<N> *dst_tree = forests[dst_info];
+                                for (unsigned int k = 0; k < dst_tree->time_info.size(); k++) {
+                                    const time_info_index &dst_index = dst_tree->time_info[k];
+                                    // scan the time info in the LM tree of the deleted landmark, as the paths to nodes in this time info map passing the deleted landmark expire, time info of these nodes
+                                    // in tree_pt may also expire, we need to check, and record the expired ones.
+                                    for (auto time_iter = dst_index.index.begin(); time_iter != dst_index.index.end(); time_iter++) {
+                                        if (tree_pt->expire_time_info(time_iter->first, k, expired_time))
+                                            deleted.push_back(merge_long_long(time_iter->first, k));
                                     }
                                 }
                             }
                         }
-                        erased.clear();
-                        visited.insert(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state));
-                        if (!deleted.empty())
-                            expire_backtrack(tree_pt->root->node_ID, tree_pt->root->state, expired_time, deleted,
-                                             visited);
-                        deleted.clear();
-                        visited.clear();
+                        unsigned int dst_ID = (dst_info >> 32);
+                        unsigned int dst_state = (dst_info & 0xFFFFFFFF);
+                        // check time info of this deleted node.
+                        if (tree_pt->expire_time_info(dst_ID, dst_state, expired_time))
+                            deleted.push_back(dst_info);
                     }
+                    erased.clear();
+                    visited.insert(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state));
+                    if (!deleted.empty())
+                        expire_backtrack(tree_pt->root->node_ID, tree_pt->root->state, expired_time, deleted,
+                                         visited);
+                    deleted.clear();
+                    visited.clear();
                 }
             }
         }
     }
 
-    void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree *tree_pt, unsigned int expired_time)
+    void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree<N> *tree_pt, unsigned int expired_time)
     // expire in normal tree, we only need to delete the nodes in the subtree.
     {
-        if (tree_pt->node_map.find(state) != tree_pt->node_map.end()) {
-            if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-                tree_node *dst_pt = tree_pt->node_map[state]->index[v];
-                if (dst_pt->timestamp < expired_time)
-                    erase_tree_node(tree_pt, dst_pt);
-            }
+        if (tree_node *dst_pt = tree_pt->find_node(v, state)) {
+            if (dst_pt->timestamp < expired_time)
+                erase_tree_node(tree_pt, dst_pt);
         }
     }
 };
@@ -15,25 +15,27 @@ using namespace std;
 
 // code for the S-PATH algorithm
 
-class S_PATH {
+template<unsigned int N>
+class S_PATH { // N is the number of states of the automaton, 0 if only known at run time (see QueryProcessorFactory)
 public:
 	FiniteStateAutomaton &aut;
 	streaming_graph &g;
 	Sink &sink;
 
-	unordered_map<unsigned long long, RPQ_tree*> forests; // map from product graph node to tree pointer
-	map<unsigned int, tree_info_index*> v2t_index; // reverse index that maps a graph vertex to the trees that contains it. The first layer maps state to tree_info_index, and the second layer maps vertex ID to list of trees contains this node
+	unordered_map<unsigned long long, RPQ_tree<N>*> forests; // map from product graph node to tree pointer
+	map<unsigned int, tree_info_index<N>*> v2t_index; // reverse index that maps a graph vertex to the trees that contains it. The first layer maps state to tree_info_index, and the second layer maps vertex ID to list of trees contains this node
+	unordered_set<unsigned long long> touched_trees; // roots of the trees that lost nodes since the last compact()
 
 	S_PATH(FiniteStateAutomaton &aut, streaming_graph &g, Sink &sink)
 		: aut(aut), g(g), sink(sink) {
 	}
 
 	~S_PATH() {
-		unordered_map<unsigned long long, RPQ_tree*>::iterator it;
+		typename unordered_map<unsigned long long, RPQ_tree<N>*>::iterator it;
 		for (it = forests.begin(); it != forests.end(); it++)
 			delete it->second;
 		forests.clear();
-		map<unsigned int, tree_info_index*>::iterator it2;
+		typename map<unsigned int, tree_info_index<N>*>::iterator it2;
 		for (it2 = v2t_index.begin(); it2 != v2t_index.end(); it2++)
 			delete it2->second;
 		v2t_index.clear();
@@ -44,18 +46,18 @@ public:
 		bool result = false;
         if (aut.getNextState(0, label) != -1 && forests.find(merge_long_long(s, 0)) == forests.end())
 		{
-			auto* new_tree = new RPQ_tree();
+			auto* new_tree = new RPQ_tree<N>(aut.states());
 			new_tree->root = add_node(new_tree, s, 0, s, nullptr, MAX_INT, MAX_INT);
 			forests[merge_long_long(s, 0)] = new_tree;
 		}
-        vector<pair<long long, long long> > vec = aut.getStatePairsWithTransition(label); // find all the state paris that can accept this label
+        const auto &vec = aut.getStatePairsWithTransition(label); // find all the state paris that can accept this label
 		for (auto &[fst, snd] : vec) {
 			unsigned int src_state = fst;
 			unsigned int dst_state = snd;
 			if (auto index_iter2 = v2t_index.find(src_state); index_iter2 != v2t_index.end())
 			{
 				if (auto tree_iter = index_iter2->second->tree_index.find(s); tree_iter != index_iter2->second->tree_index.end()) {
-					tree_info* tmp = tree_iter->second;
+					tree_info<N>* tmp = tree_iter->second;
 					while (tmp) {
 						result = insert_per_tree(s, d, label, timestamp, src_state, dst_state, tmp->tree); // for each state pair, find the trees containing (s, src_state), and update it with the new edge.
 						tmp = tmp->next;
@@ -73,7 +75,7 @@ public:
 		{
 			unsigned int dst = deleted_edge.dst;
 			unsigned int label = deleted_edge.label; // for each expired edge, find its dst node. All the expired nodes in the spanning forest must be in a subtree of such dst node.
-			std::vector<std::pair<long long, long long> > vec = aut.getStatePairsWithTransition(label);
+			const auto &vec = aut.getStatePairsWithTransition(label);
 			for (auto &[fst, snd] : vec) {
 				long long dst_state = snd;
 				if (dst_state == -1)
@@ -84,8 +86,8 @@ public:
 				if (auto iter = v2t_index.find(dst_state); iter != v2t_index.end())
 				{
 					if (auto tree_iter = iter->second->tree_index.find(dst); tree_iter != iter->second->tree_index.end()) {
-						vector<RPQ_tree*> tree_to_delete;
-						tree_info* tmp = tree_iter->second;
+						vector<RPQ_tree<N>*> tree_to_delete;
+						tree_info<N>* tmp = tree_iter->second;
 						while (tmp)	// first record the trees in the list with a vector, as when we delete expired nodes we will change the tree list, leading to error in the list scan.
 						{
 							tree_to_delete.push_back(tmp->tree);
@@ -100,7 +102,6 @@ public:
 								delete k;
 							}
 						}
-						shrink(forests);
 						tree_to_delete.clear();
 					}
 				}
@@ -120,7 +121,7 @@ public:
 			unsigned int dst = edge.dst;
 			unsigned int label = edge.label;
 
-			std::vector<std::pair<long long, long long>> vec = aut.getStatePairsWithTransition(label);
+			const auto &vec = aut.getStatePairsWithTransition(label);
 			for (auto& [src_state, dst_state] : vec) {
 				if (dst_state == -1) continue;
 
@@ -129,11 +130,11 @@ public:
 				auto tree_iter = v2t_iter->second->tree_index.find(dst);
 				if (tree_iter == v2t_iter->second->tree_index.end()) continue;
 
-				vector<RPQ_tree*> affected_trees;
-				for (tree_info* ti = tree_iter->second; ti; ti = ti->next)
+				vector<RPQ_tree<N>*> affected_trees;
+				for (tree_info<N>* ti = tree_iter->second; ti; ti = ti->next)
 					affected_trees.push_back(ti->tree);
 
-				for (RPQ_tree* tree_pt : affected_trees) {
+				for (RPQ_tree<N>* tree_pt : affected_trees) {
 					tree_node* node = tree_pt->find_node(dst, dst_state);
 					if (!node || !node->parent) continue;
 					if (node->parent->node_ID != src || node->parent->state != static_cast<unsigned int>(src_state))
@@ -145,23 +146,24 @@ public:
 					unsigned int best_timestamp = 0;
 					unsigned int best_edge_time = 0;
 
-					vector<sg_edge*> predecessors = g.get_all_pred_ptrs(dst);
-					for (sg_edge* pe : predecessors) {
-						unsigned int pred_v = pe->s;
-						unsigned int pred_label = pe->label;
-						std::vector<std::pair<long long, long long>> trans = aut.getStatePairsWithTransition(pred_label);
-						for (auto& [q_src, q_dst] : trans) {
-							if (q_dst != static_cast<long long>(dst_state)) continue;
-							tree_node* candidate = tree_pt->find_node(pred_v, q_src);
-							if (!candidate || candidate == node) continue;
-							unsigned int candidate_ts = min(candidate->timestamp, static_cast<unsigned int>(pe->timestamp));
-							if (candidate_ts > best_timestamp) {
-								best_parent = candidate;
-								best_timestamp = candidate_ts;
-								best_edge_time = pe->timestamp;
+					// only in-edges whose label leads into dst_state can re-parent the node
+					aut.forEachLabelInto(dst_state, [&](const long long pred_label) {
+						const auto &trans = aut.getStatePairsWithTransition(pred_label);
+						g.for_each_predecessor(dst, pred_label, [&](const neighbor &pe) {
+							unsigned int pred_v = pe.vertex;
+							for (auto& [q_src, q_dst] : trans) {
+								if (q_dst != static_cast<long long>(dst_state)) continue;
+								tree_node* candidate = tree_pt->find_node(pred_v, q_src);
+								if (!candidate || candidate == node) continue;
+								unsigned int candidate_ts = min(candidate->timestamp, static_cast<unsigned int>(pe.timestamp));
+								if (candidate_ts > best_timestamp) {
+									best_parent = candidate;
+									best_timestamp = candidate_ts;
+									best_edge_time = pe.timestamp;
+								}
 							}
-						}
-					}
+						});
+					});
 
 					if (best_parent) {
 						tree_pt->substitute_parent(best_parent, node);
@@ -182,7 +184,38 @@ public:
 				}
 			}
 		}
-		shrink(forests);
+	}
+
+	void save(CheckpointWriter& w) const // spanning forest and reverse index, for checkpoints
+	{
+		save_forests(w, forests);
+		save_reverse_index(w, v2t_index, forest_keys(forests));
+	}
+
+	void load(CheckpointReader& r) // restore state written by save() into an empty S_PATH
+	{
+		load_forests(r, forests, aut.states());
+		load_reverse_index(r, v2t_index, forests);
+	}
+
+	void compact() // shrink the tables that lost most of their elements since the last slide
+	{
+		compact_forests(forests, touched_trees);
+		compact_reverse_index(v2t_index);
+	}
+
+	void measure_memory(memory_usage& m) const // live bytes of the forest and the reverse index
+	{
+		measure_forests(m, forests);
+		m.v2t_index += reverse_index_memory(v2t_index);
+	}
+
+	bool holds_vertex(unsigned int v) const // true if some spanning tree has a node for v. Every tree node, roots included, is in v2t_index.
+	{
+		for (const auto &[state, index] : v2t_index)
+			if (index->tree_index.find(v) != index->tree_index.end())
+				return true;
+		return false;
 	}
 
 private:
@@ -217,19 +250,19 @@ private:
 		}
 	}
 
-	void add_index(RPQ_tree* tree_pt, unsigned int v, unsigned int state, unsigned int root_ID) // modify the reverse index to record the presence of a node in a tree. 
+	void add_index(RPQ_tree<N>* tree_pt, unsigned int v, unsigned int state, unsigned int root_ID) // modify the reverse index to record the presence of a node in a tree. 
 	{
 		auto iter = v2t_index.find(state);
 		if (iter == v2t_index.end())
-			v2t_index[state] = new tree_info_index;
+			v2t_index[state] = new tree_info_index<N>;
 		v2t_index[state]->add_node(tree_pt, v, root_ID);
 	}
 
 
-	tree_node* add_node(RPQ_tree* tree_pt, unsigned int v, unsigned int state, unsigned int root_ID, tree_node* parent, unsigned int timestamp, unsigned int edge_time) // add  a node to a spanning tree, given all the necessary information.
+	tree_node* add_node(RPQ_tree<N>* tree_pt, unsigned int v, unsigned int state, unsigned int root_ID, tree_node* parent, unsigned int timestamp, unsigned int edge_time, tree_node** slot = nullptr) // add  a node to a spanning tree, given all the necessary information. slot: see RPQ_tree::add_node
 	{
 		add_index(tree_pt, v, state, root_ID);
-		tree_node* tmp = tree_pt->add_node(v, state, parent, timestamp, edge_time);
+		tree_node* tmp = tree_pt->add_node(v, state, parent, timestamp, edge_time, slot);
 		return tmp;
 	}
 
@@ -245,7 +278,7 @@ private:
 				v2t_index.erase(iter);
 		}
 	}
-	bool expand(tree_node* expand_node, RPQ_tree* tree_pt) // function used to expand a spanning tree with a BFS manner when a new node is added into a spanning tree. expand node is the new node
+	bool expand(tree_node* expand_node, RPQ_tree<N>* tree_pt) // function used to expand a spanning tree with a BFS manner when a new node is added into a spanning tree. expand node is the new node
 	{
 		unordered_map<unsigned int, unsigned int> updated_results;
 		priority_queue<tree_node*, vector<tree_node*>, time_compare> q;
@@ -261,63 +294,60 @@ private:
 					updated_results[tmp->node_ID] = tmp->timestamp;
 			}
 
-			vector<sg_edge*> vec = g.get_all_suc_ptrs(tmp->node_ID); // get all the successor edges in the snapshot graph, and check each of them to find the successor nodes in the product graph.
-			for (auto & i : vec) {
-				unsigned int successor = i->d;
-				unsigned int edge_label = i->label;
-				long long dst_state = aut.getNextState(tmp->state, edge_label);
-				if (dst_state == -1) continue;
-				unsigned int time = min(tmp->timestamp, (unsigned int)i->timestamp);
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(successor) == tree_pt->node_map[dst_state]->index.end()) // If this node does not exit before, we add this node.
-					q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, i->timestamp));
-				else {
-					if (tree_node* dst_pt = tree_pt->node_map[dst_state]->index[successor]; dst_pt->timestamp < time) { // else if its current timestamp is smaller than the new timestamp, we update the timestamp and link it to the new parent.
-						if (dst_pt->parent != tmp) {
-							tree_pt->substitute_parent(tmp, dst_pt);
+			// visit the successor edges in the snapshot graph whose label leaves tmp->state, each of them leads to a successor node in the product graph.
+			aut.forEachLabelFrom(tmp->state, [&](const long long edge_label, const long long dst_state) {
+				g.for_each_successor(tmp->node_ID, edge_label, [&](const neighbor &i) {
+					unsigned int successor = i.vertex;
+					unsigned int time = min(tmp->timestamp, (unsigned int)i.timestamp);
+					tree_node*& dst_slot = tree_pt->node_slot(successor, dst_state);
+					if (!dst_slot) // If this node does not exit before, we add this node.
+						q.push(add_node(tree_pt, successor, dst_state, tree_pt->root->node_ID, tmp, time, i.timestamp, &dst_slot));
+					else {
+						if (tree_node* dst_pt = dst_slot; dst_pt->timestamp < time) { // else if its current timestamp is smaller than the new timestamp, we update the timestamp and link it to the new parent.
+							if (dst_pt->parent != tmp) {
+								tree_pt->substitute_parent(tmp, dst_pt);
+							}
+							dst_pt->timestamp = time;
+							dst_pt->edge_timestamp = i.timestamp;
+							q.push(dst_pt);
 						}
-						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = i->timestamp;
-						q.push(dst_pt);
 					}
-				}
-			}
+				});
+			});
 		}
 		update_result(updated_results, tree_pt->root->node_ID);
 		updated_results.clear();
 		return updated_results.empty();
 	}
 
-	bool insert_per_tree(unsigned int s, unsigned int d, unsigned int label, unsigned int timestamp, unsigned int src_state, unsigned int dst_state, RPQ_tree* tree_pt) // processing a new product graph edge from (s, src_state) to (d, dst_state) in a spanning tree tree_pt;
+	bool insert_per_tree(unsigned int s, unsigned int d, unsigned int label, unsigned int timestamp, unsigned int src_state, unsigned int dst_state, RPQ_tree<N>* tree_pt) // processing a new product graph edge from (s, src_state) to (d, dst_state) in a spanning tree tree_pt;
 	{
 		bool result = false;
-		if (tree_pt->node_map.find(src_state) != tree_pt->node_map.end())
+		if (tree_node* src_pt = tree_pt->find_node(s, src_state)) // find the src node
 		{
-			if (tree_node_index* tmp_index = tree_pt->node_map[src_state]; tmp_index->index.find(s) != tmp_index->index.end()) // find the src node
-			{
-				tree_node* src_pt = tmp_index->index[s];
-				unsigned int time = min(src_pt->timestamp, timestamp);
-				if (tree_pt->node_map.find(dst_state) == tree_pt->node_map.end() || tree_pt->node_map[dst_state]->index.find(d) == tree_pt->node_map[dst_state]->index.end()) { // if the dst node does not exist
-					tree_node* dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp);
-					result = expand(dst_pt, tree_pt); // add the dst node and further expand,
-				} else {
-					tree_node* dst_pt = tree_pt->node_map[dst_state]->index[d];
-					if (dst_pt->timestamp < time) // if the dst node exists but has a smaller timestamp, update its timestamp, and use expand to propagate the new timestamp down.
-					{
-						if (dst_pt->parent != src_pt) {
-							tree_pt->substitute_parent(src_pt, dst_pt);
-						}
-						dst_pt->timestamp = time;
-						dst_pt->edge_timestamp = timestamp;
-						result = expand(dst_pt, tree_pt);
+			unsigned int time = min(src_pt->timestamp, timestamp);
+			if (tree_node*& dst_slot = tree_pt->node_slot(d, dst_state); !dst_slot) { // if the dst node does not exist
+				tree_node* dst_pt = add_node(tree_pt, d, dst_state, tree_pt->root->node_ID, src_pt, min(src_pt->timestamp, timestamp), timestamp, &dst_slot);
+				result = expand(dst_pt, tree_pt); // add the dst node and further expand,
+			} else {
+				tree_node* dst_pt = dst_slot;
+				if (dst_pt->timestamp < time) // if the dst node exists but has a smaller timestamp, update its timestamp, and use expand to propagate the new timestamp down.
+				{
+					if (dst_pt->parent != src_pt) {
+						tree_pt->substitute_parent(src_pt, dst_pt);
 					}
+					dst_pt->timestamp = time;
+					dst_pt->edge_timestamp = timestamp;
+					result = expand(dst_pt, tree_pt);
 				}
 			}
 		}
 		return result;
 	}
 
-	void erase_tree_node(RPQ_tree* tree_pt, tree_node* child) // given an expired node, delete the subtree rooted at it in tree_pt, all the nodes in its subtree also expire.
+	void erase_tree_node(RPQ_tree<N>* tree_pt, tree_node* child) // given an expired node, delete the subtree rooted at it in tree_pt, all the nodes in its subtree also expire.
 	{
+		touched_trees.insert(merge_long_long(tree_pt->root->node_ID, tree_pt->root->state));
 		queue<tree_node*> q;
 		q.push(child);
 		tree_pt->separate_node(child); // 'child' is disconnected with its parent, other nodes do not need to call this function, as there parents and brothers are all deleted;
@@ -333,14 +363,10 @@ private:
 		}
 	}
 
-	void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree* tree_pt, unsigned int expired_time) // given a product graph node (v, state) which can possibly be an expired node, try to delete its subtree.
+	void expire_per_tree(unsigned int v, unsigned int state, RPQ_tree<N>* tree_pt, unsigned int expired_time) // given a product graph node (v, state) which can possibly be an expired node, try to delete its subtree.
 	{
-		if (tree_pt->node_map.find(state) != tree_pt->node_map.end()) {
-			if (tree_pt->node_map[state]->index.find(v) != tree_pt->node_map[state]->index.end()) {
-				if (tree_node* dst_pt = tree_pt->node_map[state]->index[v]; dst_pt->timestamp < expired_time) // if it is indeed an expired node, delete its subtree.
-					erase_tree_node(tree_pt, dst_pt);
-			}
-		}
+		if (tree_node* dst_pt = tree_pt->find_node(v, state); dst_pt && dst_pt->timestamp < expired_time) // if it is indeed an expired node, delete its subtree.
+			erase_tree_node(tree_pt, dst_pt);
 	}
 
 	void print_tree(unsigned int ID, unsigned int state)
@@ -377,18 +403,15 @@ private:
 	void print_path(unsigned int ID, unsigned int root_state, unsigned int dst, unsigned int dst_state)
 	{
 		if (auto iter = forests.find(merge_long_long(ID, root_state)); iter != forests.end()) {
-			if (iter->second->node_map.find(dst_state) != iter->second->node_map.end()) {
-				if (iter->second->node_map[dst_state]->index.find(dst) != iter->second->node_map[dst_state]->index.end()) {
-					tree_node* tmp = iter->second->node_map[dst_state]->index[dst];
-					while (tmp)
-					{
-						cout << tmp->node_ID << ' ' << tmp->state << ' ' << tmp->edge_timestamp << ' ' << tmp->timestamp << ' ';
-						if (tmp->parent)
-							cout << tmp->parent->node_ID << ' ' << tmp->parent->state << endl;
-						else
-							cout << "NULL" << endl;
-						tmp = tmp->parent;
-					}
+			if (tree_node* tmp = iter->second->find_node(dst, dst_state)) {
+				while (tmp)
+				{
+					cout << tmp->node_ID << ' ' << tmp->state << ' ' << tmp->edge_timestamp << ' ' << tmp->timestamp << ' ';
+					if (tmp->parent)
+						cout << tmp->parent->node_ID << ' ' << tmp->parent->state << endl;
+					else
+						cout << "NULL" << endl;
+					tmp = tmp->parent;
 				}
 			}
 		}
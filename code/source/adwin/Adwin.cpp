@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <cmath>
 #include "Adwin.h"
+#include "../checkpoint_io.h"
 
 #include <iostream>
 
@@ -262,3 +263,49 @@ void Adwin::print() const {
 
 
 ////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Adwin::save(CheckpointWriter &w) const {
+    w.put(mintTime);
+    w.put(mintClock);
+    w.put(mdblError);
+    w.put(mdblWidth);
+    w.put(bucketNumber);
+    w.put(W);
+    w.put(lastBucketRow);
+    w.put(sum);
+    w.put(var);
+    w.put(lastEstimation);
+    w.put(positiveChange);
+    w.put(bucketList.count);
+    for (const ListNode *node = bucketList.head; node; node = node->next) {
+        w.put(node->size);
+        w.put_vector(node->sum);
+        w.put_vector(node->variance);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Adwin::load(CheckpointReader &r) {
+    r.get(mintTime);
+    r.get(mintClock);
+    r.get(mdblError);
+    r.get(mdblWidth);
+    r.get(bucketNumber);
+    r.get(W);
+    r.get(lastBucketRow);
+    r.get(sum);
+    r.get(var);
+    r.get(lastEstimation);
+    r.get(positiveChange);
+    while (bucketList.count > 0) bucketList.removeFromTail();
+    for (int i = r.get<int>(); i > 0; i--) {
+        bucketList.addToTail();
+        ListNode *node = bucketList.tail;
+        r.get(node->size);
+        r.get_vector(node->sum);
+        r.get_vector(node->variance);
+    }
+}
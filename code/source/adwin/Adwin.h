@@ -25,6 +25,9 @@
 
 #include "List.h"
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class Adwin {
 public:
     Adwin(int _M, int MINLEN, double DELTA);
@@ -37,6 +40,11 @@ public:
 
     [[nodiscard]] int length() const { return W; }
 
+    // Write / restore the bucket list and running statistics (checkpoints).
+    void save(CheckpointWriter &w) const;
+
+    void load(CheckpointReader &r);
+
     bool positiveChange = false;
 
 private:
@@ -0,0 +1,257 @@
+#ifndef ADA_CHECKPOINT_H
+#define ADA_CHECKPOINT_H
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "checkpoint_io.h"
+#include "vertex_dictionary.h"
+#include "modes/mode_handler.h"
+
+// ---------------------------------------------------------------------------
+// Engine checkpoints (`checkpoint_path`, `checkpoint_every`, `restore_from`)
+//
+// A snapshot holds everything the stream loop in main.cpp would otherwise
+// rebuild by replaying the input from t0: the streaming graph, the spanning
+// forests of the selected algorithm, the Sink result set, the ModeContext
+// windows and slides, the mode handler's own state, the vertex dictionary and
+// the stream position. Restoring costs time proportional to the snapshot, and
+// ingest resumes with the first record after the last processed edge.
+//
+// Processing-clock values (window and slide open times, the loop start) are
+// stored relative to the moment of the snapshot, so latencies and exec_time
+// carry on across the restart.
+// ---------------------------------------------------------------------------
+
+// Progress of the stream loop in main.cpp.
+struct StreamProgress {
+    std::uint64_t records = 0;          // raw input records consumed up to the last processed edge
+    long long t0 = 0;                   // EdgePrefilter time origin
+    long long elements_processed = 0;
+    double cumulative_processing_time = 0;
+    double processing_seconds = 0;      // processing_clock() time spent in the loop
+    std::uint64_t slides_at_reclaim = 0;
+    std::uint64_t functions_csv_bytes = 0; // length of the functions_results CSV at the snapshot
+    std::uint64_t rehashes = 0;         // rehash_stats at the snapshot
+    double rehash_seconds = 0;
+};
+
+namespace checkpoint_format {
+    constexpr std::array<char, 4> magic = {'A', 'D', 'A', 'C'};
+    constexpr std::uint16_t version = 5;
+}
+
+// Configuration the engine state depends on; a snapshot is only restored into
+// a run with the same fingerprint.
+inline std::string checkpoint_fingerprint(const config &cfg) {
+    std::string labels;
+    for (const long long l : cfg.labels) labels += std::to_string(l) + ",";
+    return "mode=" + std::to_string(cfg.mode) +
+           ";path_algorithm=" + std::to_string(cfg.path_algorithm) +
+           ";query_type=" + std::to_string(cfg.query_type) +
+           ";query=" + cfg.query +
+           ";labels=" + labels +
+           ";size=" + std::to_string(cfg.size) +
+           ";slide=" + std::to_string(cfg.slide) +
+           ";min_size=" + std::to_string(cfg.min_size) +
+           ";max_size=" + std::to_string(cfg.max_size) +
+           ";replay_profile=" + cfg.replay_profile +
+           ";replay_rate=" + std::to_string(cfg.replay_rate) +
+           ";max_lateness=" + std::to_string(cfg.max_lateness);
+}
+
+inline void save_context(CheckpointWriter &w, const ModeContext &ctx, const clock_t now) {
+    w.put_size(ctx.windows.size());
+    for (const window &win : ctx.windows) {
+        w.put(win.t_open);
+        w.put(win.t_close);
+        w.put(win.evicted);
+        w.put(win.start_time - now);
+        w.put(win.latency);
+        w.put(win.normalized_latency);
+        w.put(win.cost);
+        w.put(win.max_degree);
+        w.put(win.elements_count);
+        w.put(win.window_matches);
+        w.put(win.results_at_open);
+        w.put(win.results_at_close);
+        w.put(win.total_matched_results);
+        w.put(win.emitted_results);
+    }
+    w.put_size(ctx.slides.size());
+    for (const Slide &slide : ctx.slides) {
+        Slide rebased = slide;
+        rebased.wall_open -= now;
+        rebased.wall_close -= now;
+        w.put(rebased);
+    }
+
+    w.put(ctx.size);
+    w.put(ctx.edge_number);
+    w.put(ctx.window_offset);
+    w.put_vector(ctx.to_evict);
+    w.put(ctx.cumulative_size);
+    w.put(ctx.size_count);
+    w.put(ctx.avg_size);
+    w.put(ctx.cost_max);
+    w.put(ctx.cost_min);
+    w.put(ctx.lat_max);
+    w.put(ctx.lat_min);
+    w.put(ctx.cost);
+    w.put(ctx.cost_norm);
+    w.put(ctx.last_cost);
+    w.put(ctx.last_diff);
+    w.put(ctx.max_deg);
+    w.put(ctx.max_deg_dirty);
+    w.put_vector(std::vector<double>(ctx.cost_normalization_window.begin(), ctx.cost_normalization_window.end()));
+    w.put(ctx.cost_normalization_dirty);
+    w.put_vector(std::vector<double>(ctx.cost_window.begin(), ctx.cost_window.end()));
+    w.put(ctx.cost_window_sum);
+    w.put(ctx.warmup);
+    w.put(ctx.resizings);
+    w.put(ctx.window_cardinality);
+    w.put(ctx.p_shed);
+    w.put(ctx.average_processing_time);
+    w.put(ctx.total_elements_count);
+    w.put(ctx.cumulative_window_latency);
+    w.put(ctx.beta_latency_start - static_cast<double>(now));
+    w.put(ctx.beta_latency_end);
+    w.put(ctx.beta_id);
+    w.put(ctx.beta_elements_cont);
+    w.put(ctx.last_oi);
+    w.put(ctx.current_slide_open);
+    w.put_vector(ctx.cumulative_processing_time_type);
+    w.put_vector(ctx.processed_elements_type);
+    w.put_vector(ctx.input_rate_type);
+}
+
+inline void load_context(CheckpointReader &r, ModeContext &ctx, const clock_t now) {
+    ctx.windows.clear();
+    for (std::size_t i = r.get_size(); i > 0; i--) {
+        const auto t_open = r.get<long long>();
+        const auto t_close = r.get<long long>();
+        window &win = ctx.windows.emplace_back(t_open, t_close, 0);
+        r.get(win.evicted);
+        win.start_time = r.get<clock_t>() + now;
+        r.get(win.latency);
+        r.get(win.normalized_latency);
+        r.get(win.cost);
+        r.get(win.max_degree);
+        r.get(win.elements_count);
+        r.get(win.window_matches);
+        r.get(win.results_at_open);
+        r.get(win.results_at_close);
+        r.get(win.total_matched_results);
+        r.get(win.emitted_results);
+    }
+    ctx.slides.clear();
+    for (std::size_t i = r.get_size(); i > 0; i--) {
+        Slide &slide = ctx.slides.emplace_back(r.get<Slide>());
+        slide.wall_open += now;
+        slide.wall_close += now;
+    }
+
+    r.get(ctx.size);
+    r.get(ctx.edge_number);
+    r.get(ctx.window_offset);
+    r.get_vector(ctx.to_evict);
+    r.get(ctx.cumulative_size);
+    r.get(ctx.size_count);
+    r.get(ctx.avg_size);
+    r.get(ctx.cost_max);
+    r.get(ctx.cost_min);
+    r.get(ctx.lat_max);
+    r.get(ctx.lat_min);
+    r.get(ctx.cost);
+    r.get(ctx.cost_norm);
+    r.get(ctx.last_cost);
+    r.get(ctx.last_diff);
+    r.get(ctx.max_deg);
+    r.get(ctx.max_deg_dirty);
+    std::vector<double> values;
+    r.get_vector(values);
+    ctx.cost_normalization_window.assign(values.begin(), values.end());
+    r.get(ctx.cost_normalization_dirty);
+    r.get_vector(values);
+    ctx.cost_window.assign(values.begin(), values.end());
+    r.get(ctx.cost_window_sum);
+    r.get(ctx.warmup);
+    r.get(ctx.resizings);
+    r.get(ctx.window_cardinality);
+    r.get(ctx.p_shed);
+    r.get(ctx.average_processing_time);
+    r.get(ctx.total_elements_count);
+    r.get(ctx.cumulative_window_latency);
+    ctx.beta_latency_start = r.get<double>() + static_cast<double>(now);
+    r.get(ctx.beta_latency_end);
+    r.get(ctx.beta_id);
+    r.get(ctx.beta_elements_cont);
+    r.get(ctx.last_oi);
+    r.get(ctx.current_slide_open);
+    r.get_vector(ctx.cumulative_processing_time_type);
+    r.get_vector(ctx.processed_elements_type);
+    r.get_vector(ctx.input_rate_type);
+}
+
+// Writes the snapshot next to path and renames it into place, so a crash
+// while writing leaves the previous checkpoint intact.
+inline bool save_checkpoint(const std::string &path, const std::string &fingerprint, const ModeContext &ctx,
+                            const ModeHandler &mode_handler, const VertexDictionary &vertices,
+                            const StreamProgress &progress) {
+    const std::string tmp_path = path + ".tmp";
+    const clock_t now = processing_clock();
+    CheckpointWriter w(tmp_path);
+    w.put(checkpoint_format::magic);
+    w.put(checkpoint_format::version);
+    w.put_string(fingerprint);
+    w.put(progress);
+    save_context(w, ctx, now);
+    ctx.sg->save(w);
+    ctx.q->save(w);
+    ctx.sink->save(w);
+    vertices.save(w);
+    mode_handler.save(w);
+    w.put(checkpoint_format::magic);
+    w.close();
+    if (!w.good()) {
+        std::cerr << "Error: failed to write checkpoint " << tmp_path << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::cerr << "Error: failed to move checkpoint to " << path << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Loads a snapshot into a freshly constructed engine: ctx must hold empty
+// graph, query and sink objects and mode_handler must be newly created.
+inline StreamProgress restore_checkpoint(const std::string &path, const std::string &fingerprint, ModeContext &ctx,
+                                         ModeHandler &mode_handler, VertexDictionary &vertices) {
+    CheckpointReader r(path);
+    if (!r.is_open()) r.fail("cannot open");
+    if (r.get<std::array<char, 4>>() != checkpoint_format::magic) r.fail("not a checkpoint");
+    if (r.get<std::uint16_t>() != checkpoint_format::version) r.fail("unsupported version");
+    if (const std::string saved = r.get_string(); saved != fingerprint)
+        r.fail("written with a different configuration (" + saved + ")");
+
+    const clock_t now = processing_clock();
+    const auto progress = r.get<StreamProgress>();
+    load_context(r, ctx, now);
+    ctx.sg->load(r);
+    ctx.q->load(r);
+    ctx.sink->load(r);
+    vertices.load(r);
+    mode_handler.load(r);
+    if (r.get<std::array<char, 4>>() != checkpoint_format::magic) r.fail("corrupt");
+    return progress;
+}
+
+#endif //ADA_CHECKPOINT_H
@@ -0,0 +1,152 @@
+#ifndef ADA_CHECKPOINT_IO_H
+#define ADA_CHECKPOINT_IO_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// CheckpointWriter / CheckpointReader  —  flat binary encoding of engine
+// state for checkpoint.h
+//
+// Values are written in host byte order: a snapshot is restored by the same
+// build on the same machine, not exchanged. Every container is written as a
+// uint64 length followed by its elements. The reader exits with an error on a
+// truncated file instead of returning partial state.
+// ---------------------------------------------------------------------------
+class CheckpointWriter {
+    std::ofstream out_;
+
+public:
+    explicit CheckpointWriter(const std::string &path) : out_(path, std::ios::binary | std::ios::trunc) {}
+
+    [[nodiscard]] bool good() const {
+        return out_.good();
+    }
+
+    void close() {
+        out_.close();
+    }
+
+    template<typename T>
+    void put(const T &v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out_.write(reinterpret_cast<const char *>(&v), sizeof(T));
+    }
+
+    void put_size(const std::size_t n) {
+        put<std::uint64_t>(n);
+    }
+
+    void put_string(const std::string &s) {
+        put_size(s.size());
+        out_.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+
+    template<typename T>
+    void put_vector(const std::vector<T> &v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        put_size(v.size());
+        out_.write(reinterpret_cast<const char *>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+    }
+
+    void put_vector(const std::vector<bool> &v) {
+        put_size(v.size());
+        for (const bool b : v) put<std::uint8_t>(b);
+    }
+
+    template<typename K, typename V, typename H>
+    void put_map(const std::unordered_map<K, V, H> &m) {
+        put_size(m.size());
+        for (const auto &[k, v] : m) {
+            put(k);
+            put(v);
+        }
+    }
+
+    template<typename K>
+    void put_set(const std::unordered_set<K> &s) {
+        put_size(s.size());
+        for (const auto &k : s) put(k);
+    }
+};
+
+class CheckpointReader {
+    std::ifstream in_;
+    std::string path_;
+
+public:
+    explicit CheckpointReader(const std::string &path) : in_(path, std::ios::binary), path_(path) {}
+
+    [[nodiscard]] bool is_open() const {
+        return in_.is_open();
+    }
+
+    [[noreturn]] void fail(const std::string &what) const {
+        std::cerr << "Error: checkpoint " << path_ << ": " << what << std::endl;
+        exit(1);
+    }
+
+    template<typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T v{};
+        if (!in_.read(reinterpret_cast<char *>(&v), sizeof(T))) fail("truncated");
+        return v;
+    }
+
+    template<typename T>
+    void get(T &v) {
+        v = get<T>();
+    }
+
+    std::size_t get_size() {
+        return static_cast<std::size_t>(get<std::uint64_t>());
+    }
+
+    std::string get_string() {
+        std::string s(get_size(), '\0');
+        if (!in_.read(s.data(), static_cast<std::streamsize>(s.size()))) fail("truncated");
+        return s;
+    }
+
+    template<typename T>
+    void get_vector(std::vector<T> &v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        v.resize(get_size());
+        if (!in_.read(reinterpret_cast<char *>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T))))
+            fail("truncated");
+    }
+
+    void get_vector(std::vector<bool> &v) {
+        v.resize(get_size());
+        for (std::size_t i = 0; i < v.size(); i++) v[i] = get<std::uint8_t>() != 0;
+    }
+
+    template<typename K, typename V, typename H>
+    void get_map(std::unordered_map<K, V, H> &m) {
+        const std::size_t n = get_size();
+        m.clear();
+        m.reserve(n);
+        for (std::size_t i = 0; i < n; i++) {
+            const K k = get<K>();
+            m.emplace(k, get<V>());
+        }
+    }
+
+    template<typename K>
+    void get_set(std::unordered_set<K> &s) {
+        const std::size_t n = get_size();
+        s.clear();
+        s.reserve(n);
+        for (std::size_t i = 0; i < n; i++) s.insert(get<K>());
+    }
+};
+
+#endif //ADA_CHECKPOINT_IO_H
@@ -1,4 +1,5 @@
 #pragma once
+#include<array>
 #include<map>
 #include<unordered_map>
 #include<unordered_set>
@@ -7,29 +8,39 @@
 #include <iostream>
 #include <list>
 #include <algorithm>
-#define um_shrink_threshold 2
+#include <climits>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "checkpoint_io.h"
+#include "memory_usage.h"
+#define um_shrink_threshold 8 // buckets per element above which a table is shrunk
+#define um_shrink_target 2 // buckets per element after shrinking
+#define um_min_buckets 16 // tables this small are never shrunk
 #define merge_long_long(s, d) (((unsigned long long)s<<32)|d)
 using namespace std;
 #define MAX_INT 0x7FFFFFFF
 
 // this file defines the basic structures and associated functions shared by both S-PATH and LM-SRPQ. Note that some variables are not needed by S-PATH, and they will not be included in memory computation for S-PATH.
 
-template<typename K, typename V>
-void shrink(unordered_map<K, V>& um)  // this function shrinks the bucket number of unordered map (um) if the number of bucket is 2 times larger than the number of KV pairs.
-//Because the system will not automatically shrink the unordered_map or unordered_set, the bucket number may be much larger than the KV number if a lot of KV are inserted into the um the then deleted.
+struct rehash_stats // shrink rehashes done by the compaction passes, over the whole run
 {
-	if (um.empty()) return;
-	if (static_cast<double>(um.bucket_count()) / um.size() > um_shrink_threshold) {
-		um.reserve(um.size());
-	}
-}
+	static inline uint64_t count = 0;
+	static inline double seconds = 0;
+};
 
-template<typename K>
-void shrink(unordered_set<K>& us) // this function shrinks the bucket number of unordered set
+template<typename C>
+void shrink(C& um) // shrinks the bucket array of an unordered map or set once it has more than um_shrink_threshold buckets per element.
+// The system never shrinks an unordered_map or unordered_set by itself, so a table keeps its peak bucket count after mass deletions. Erasures do not call this:
+// the trees that lost entries are compacted once per slide (see compact_forests), and a shrunk table keeps um_shrink_target buckets per element, so it has to double before
+// the system grows it again and lose three quarters of its elements before it is shrunk again.
 {
-	if (us.empty()) return;
-	if (static_cast<double>(us.bucket_count()) / us.size() > um_shrink_threshold)
-		us.reserve(us.size());
+	if (um.bucket_count() <= um_min_buckets || um.bucket_count() <= um_shrink_threshold * um.size()) return;
+	const auto start = chrono::steady_clock::now();
+	um.rehash(um_shrink_target * um.size());
+	rehash_stats::count++;
+	rehash_stats::seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
 }
 
 struct tree_node // node in the spanning tree
@@ -42,6 +53,7 @@ struct tree_node // node in the spanning tree
 	tree_node* parent;	// pointer to parent. As we may need to move a subtree from one parent to another, a parent pointer will accelerate this procedure, as suggested by the authors.
 	tree_node* child;
 	tree_node* brother;	// first child and list of brother, classic method for tree maintaining
+	tree_node* prev_brother; // previous node in the child list of the parent, nullptr for the first child. It lets a node leave the list without scanning it, which matters for hub vertices with many children.
 	tree_node(unsigned int ID, unsigned int state_, unsigned int time, unsigned int edge_time)
 	{
 		node_ID = ID;
@@ -52,15 +64,132 @@ struct tree_node // node in the spanning tree
 		parent = nullptr;
 		child = nullptr;
 		brother = nullptr;
+		prev_brother = nullptr;
 	}
 };
 
-struct tree_node_index //  maps a vertex ID to the tree node in a spanning tree
+class product_node_index // maps a product graph node, merge_long_long(vertex ID, state), to its tree node in a spanning tree.
+// Open addressing with linear probing over a power-of-two slot array. The key and the node pointer are stored inline in the slot, so a lookup is one hash and
+// usually one cache line, and find_or_insert resolves a lookup and the following insertion with a single probe. Erasure shifts the following entries of the
+// cluster back instead of leaving tombstones. bucket_count and rehash follow unordered_map, so shrink() compacts it like the other tables.
 {
-	unordered_map<unsigned int, tree_node*> index;
-	~tree_node_index()
+	struct slot
 	{
-		index.clear();
+		unsigned long long key;
+		tree_node* node;
+	};
+	static constexpr unsigned long long empty_key = ~0ULL; // vertex ID and state 0xFFFFFFFF, which no product graph node has
+	vector<slot> slots;
+	size_t count = 0;
+	unsigned int shift = 64; // 64 - log2(slots.size())
+
+	size_t home(unsigned long long key) const // Fibonacci hashing, so that keys differing only in the vertex ID or only in the state spread over the table
+	{
+		return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+	}
+	size_t probe(unsigned long long key) const // slot holding key, or the empty slot ending its cluster. The table must not be empty
+	{
+		const size_t mask = slots.size() - 1;
+		size_t i = home(key);
+		while (slots[i].key != key && slots[i].key != empty_key)
+			i = (i + 1) & mask;
+		return i;
+	}
+	void resize(size_t capacity) // capacity is a power of two larger than the number of elements
+	{
+		vector<slot> old;
+		old.swap(slots);
+		slots.assign(capacity, slot{empty_key, nullptr});
+		shift = 64 - __builtin_ctzll(capacity);
+		for (const slot& e : old)
+			if (e.key != empty_key)
+				slots[probe(e.key)] = e;
+	}
+
+public:
+	tree_node* find(unsigned long long key) const
+	{
+		if (count == 0)
+			return nullptr;
+		return slots[probe(key)].node;
+	}
+	tree_node*& find_or_insert(unsigned long long key) // the node of key, or a new empty handle for key that the caller fills; the reference is valid until the next insertion
+	{
+		if (4 * (count + 1) > 3 * slots.size()) // keep the load factor at most 3/4
+			resize(slots.empty() ? 4 : 2 * slots.size());
+		slot& e = slots[probe(key)];
+		if (e.key == empty_key)
+		{
+			e.key = key;
+			count++;
+		}
+		return e.node;
+	}
+	tree_node* erase(unsigned long long key) // removes key and returns its node, nullptr if it is not in the table
+	{
+		if (count == 0)
+			return nullptr;
+		const size_t mask = slots.size() - 1;
+		size_t hole = probe(key);
+		if (slots[hole].key == empty_key)
+			return nullptr;
+		tree_node* node = slots[hole].node;
+		for (size_t i = (hole + 1) & mask; slots[i].key != empty_key; i = (i + 1) & mask)
+		{
+			if (((i - home(slots[i].key)) & mask) >= ((i - hole) & mask)) // the entry can move back into the hole without passing its home slot
+			{
+				slots[hole] = slots[i];
+				hole = i;
+			}
+		}
+		slots[hole] = slot{empty_key, nullptr};
+		count--;
+		return node;
+	}
+	template<typename F>
+	void for_each(F&& f) const // calls f(node) for every node in the table
+	{
+		if (count == 0)
+			return;
+		for (const slot& e : slots)
+			if (e.key != empty_key && e.node)
+				f(e.node);
+	}
+	void clear()
+	{
+		if (count == 0)
+			return;
+		fill(slots.begin(), slots.end(), slot{empty_key, nullptr});
+		count = 0;
+	}
+	size_t size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	size_t bucket_count() const
+	{
+		return slots.size();
+	}
+	void rehash(size_t n) // resizes to the smallest power of two that holds max(n, size()) elements within the load factor; 0 on an empty table frees the slots
+	{
+		if (count == 0 && n == 0)
+		{
+			vector<slot>().swap(slots);
+			shift = 64;
+			return;
+		}
+		size_t capacity = 4;
+		while (capacity < n || 3 * capacity < 4 * count)
+			capacity *= 2;
+		resize(capacity);
+	}
+	size_t memory() const
+	{
+		return memory_estimate::vector(slots);
 	}
 };
 struct time_info_index // maps a vertex ID to the timestamp in TI map;
@@ -71,22 +200,52 @@ struct time_info_index // maps a vertex ID to the timestamp in TI map;
 		index.clear();
 	}
 };
+struct vertex_refs // number of entries some tables hold for each dense vertex ID, so that one lookup tells whether a vertex is still referenced
+{
+	vector<unsigned int> count;
+	void add(unsigned int v)
+	{
+		if (v >= count.size())
+			count.resize(v + 1, 0);
+		count[v]++;
+	}
+	void remove(unsigned int v)
+	{
+		count[v]--;
+	}
+	bool holds(unsigned int v) const
+	{
+		return v < count.size() && count[v] != 0;
+	}
+	size_t memory() const
+	{
+		return memory_estimate::vector(count);
+	}
+};
 
-class RPQ_tree // class for the spanning trees in the spanning forest.
+template<typename T, unsigned int N> // one T per automaton state, indexed by the state: inline for the N states of a registered query shape (see QueryProcessorFactory), or a vector sized when the tree is built if N is 0
+using per_state = conditional_t<N == 0, vector<T>, array<T, N>>;
+
+template<unsigned int N>
+class RPQ_tree // class for the spanning trees in the spanning forest. N is the number of states of the automaton, 0 if the trees size their state tables at run time.
 {
 public:
 	tree_node* root;
-	map<unsigned int, tree_node_index*> node_map; // map from a state to the relevant node index. In the node index the reverse map from vertex ID to the tree node pointer is stored. The state in the first layer an the vertex ID in the second layer form a product graph node ID 
-	map<unsigned int, time_info_index*> time_info; // TI map, used by LM-SRPQ, but not by S-PATH. Maps a state to the relevant time_info_index. In each the reverse index we map vertex ID to the timestamp in TI map.The state in the first layer an the vertex ID in the second layer form a product graph node ID 
+	product_node_index node_map; // maps each product graph node in this tree to its tree node
+	per_state<time_info_index, N> time_info; // TI map, used by LM-SRPQ, but not by S-PATH. The time_info_index of each state. In each the reverse index we map vertex ID to the timestamp in TI map.The state in the first layer an the vertex ID in the second layer form a product graph node ID 
 	unordered_set<unsigned long long> landmarks; // set of landmarks contained in this tree. Merge the vertex ID and state with merge_long_long. Used by LM-SRPQ.
 	unordered_map<unsigned long long, unsigned int> timed_landmarks; // this structure is used to directly get the landmarks and the timestamp of this landmark in the spanning tree. 
 	// This structure is used when we need to traverse forward in the dependency graph, and thus is only needed in the dependency-forest version of LM-SRPQ
 	int node_cnt;
+	vertex_refs* ti_refs; // if set, counts the TI map entries of each vertex over all the trees sharing it
 
-	RPQ_tree()
+	explicit RPQ_tree([[maybe_unused]] unsigned int states = N)
 	{
 		root = nullptr;
 		node_cnt = 0;
+		ti_refs = nullptr;
+		if constexpr (N == 0)
+			time_info.resize(states);
 	}
 	void clear()
 	{
@@ -105,21 +264,28 @@ public:
 				}
 				delete tmp;
 			}
-			for (auto &[fst, snd] : node_map)
-				delete snd;
-			for (auto &[fst, snd] : time_info)
-				delete snd;
 			node_map.clear();
 			landmarks.clear();
-			time_info.clear();
 			root = nullptr;
 		}
+		clear_time_info();
 	}
 	void clear_time_info() // clear the TI map, used when a spanning tree is not an LM tree any more.
 	{
-		for (auto & iter : time_info)
-			delete iter.second;
-		time_info.clear();
+		for (auto &states_index : time_info)
+		{
+			if (ti_refs)
+				for (const auto &entry : states_index.index)
+					ti_refs->remove(entry.first);
+			states_index.index.clear();
+		}
+	}
+	void count_time_info(vertex_refs* refs) // count the TI map entries of this tree in refs, the present ones and those added later. The TI map must only change through the functions below.
+	{
+		ti_refs = refs;
+		for (const auto &states_index : time_info)
+			for (const auto &entry : states_index.index)
+				ti_refs->add(entry.first);
 	}
 	~RPQ_tree()
 	{
@@ -127,42 +293,60 @@ public:
 	}
 	void add_time_info(unsigned int v, unsigned int state, unsigned int time) // add a product graph node ID + timestamp pair to the TI map
 	{
-		if (time_info.find(state) == time_info.end())
-			time_info[state] = new time_info_index;
-		time_info[state]->index[v] = time;
+		if (auto [it, inserted] = time_info[state].index.insert_or_assign(v, time); inserted && ti_refs)
+			ti_refs->add(v);
+	}
+	bool raise_time_info(unsigned int v, unsigned int state, unsigned int time) // add the pair, or raise the timestamp of the product graph node to time; true if the TI map changed
+	{
+		auto [it, inserted] = time_info[state].index.try_emplace(v, time);
+		if (inserted)
+		{
+			if (ti_refs)
+				ti_refs->add(v);
+			return true;
+		}
+		if (it->second >= time)
+			return false;
+		it->second = time;
+		return true;
+	}
+	bool expire_time_info(unsigned int v, unsigned int state, unsigned int expired_time) // erase the TI map entry of a product graph node if its timestamp is below expired_time; true if it was erased
+	{
+		auto &index = time_info[state].index;
+		auto it = index.find(v);
+		if (it == index.end() || it->second >= expired_time)
+			return false;
+		index.erase(it);
+		if (ti_refs)
+			ti_refs->remove(v);
+		return true;
 	}
 	unsigned int get_time_info(unsigned int v, unsigned int state) // get the timestamp of a product graph node in the TI map
 	{
-		if (time_info.find(state) == time_info.end())
-			return 0;
-		if (time_info[state]->index.find(v) != time_info[state]->index.end())
-			return time_info[state]->index[v];
-		else
-			return 0;
+		const auto &index = time_info[state].index;
+		if (auto it = index.find(v); it != index.end())
+			return it->second;
+		return 0;
 	}
-	tree_node* add_node(unsigned int v, unsigned int state, tree_node* parent, unsigned int time, unsigned int edge_time) // add a new tree node with given ID, state, node time ,edge time and parent
+	tree_node*& node_slot(unsigned int v, unsigned int state) // given a product graph node, return the handle of its tree node in the node map, nullptr if it is not in the tree yet.
+	// A null handle must be filled through add_node before anything else is added to the tree.
+	{
+		return node_map.find_or_insert(merge_long_long(v, state));
+	}
+	tree_node* add_node(unsigned int v, unsigned int state, tree_node* parent, unsigned int time, unsigned int edge_time, tree_node** slot = nullptr) // add a new tree node with given ID, state, node time ,edge time and parent.
+	// slot is the handle node_slot returned for (v, state), which saves a second probe of the node map
 	{
 		auto* tmp = new tree_node(v, state, time, edge_time);
-		tmp->parent = parent;
-		if (parent) {
-			tmp->brother = parent->child; // add this node to the head of the child list of the parent
-			parent->child = tmp;
-		} else tmp->brother = nullptr;
-		if (node_map.find(state) == node_map.end())
-			node_map[state] = new tree_node_index;
-		node_map[state]->index[v] = tmp; // add this node to the node map
+		if (parent)
+			link_child(parent, tmp); // add this node to the head of the child list of the parent
+		(slot ? *slot : node_slot(v, state)) = tmp; // add this node to the node map
 		node_cnt++;
 		return tmp;
 	}
 	void set_lm(unsigned int v, unsigned int state) // set the LM tag of a node to true;
 	{
-		if (node_map.find(state) == node_map.end()) {
-			if (node_map[state]->index.find(v) != node_map[state]->index.end())
-			{
-				tree_node* tmp = node_map[state]->index[v];
-				tmp->lm = true;
-			}
-		}
+		if (tree_node* tmp = find_node(v, state))
+			tmp->lm = true;
 	}
 
 	void add_lm(unsigned long long lm) // add a node into the LM set.
@@ -177,34 +361,15 @@ public:
 	{
 		if (child->parent == nullptr)
 			return;
-		if (child->parent->child == child) // find the node in the child list of the parent, and split it.
-			child->parent->child = child->brother;
-		else
-		{
-			tree_node* tmp = child->parent->child;
-			while (tmp != nullptr && tmp->brother != child)
-				tmp = tmp->brother;
-			if (!tmp) {
-				cerr << "Error: child node not found in the child list of its parent." << endl;
-				exit(-1);
-			}
-			tmp->brother = child->brother;
-		}
+		unlink_child(child);
 		child->parent = nullptr;
 	}
 
 	void remove_node(tree_node* node) // delete a node from the node map and the landmark set (if it is in the landmark set)
 	{
-		if (node_map.find(node->state) != node_map.end())
-		{
-			node_map[node->state]->index.erase(node->node_ID);
-			shrink(node_map[node->state]->index);
-			if (node_map[node->state]->index.empty())
-				node_map.erase(node->state);
-		}
+		node_map.erase(merge_long_long(node->node_ID, node->state));
 		node_cnt--; // need to modify the node index in the upper layer.
 		landmarks.erase(static_cast<unsigned long long>(node->node_ID) << 32 | node->state);
-		shrink(landmarks);
 	}
 	void delete_node(tree_node* node) // delete a node, including separate it from and tree and delete it in the node map
 	{
@@ -214,30 +379,19 @@ public:
 	void remove_lm(tree_node* node) // delete a landmark.
 	{
 		landmarks.erase(node->node_ID);
-		shrink(landmarks);
 	}
 	void remove_lm(unsigned long long ID)
 	{
 		landmarks.erase(ID);
-		shrink(landmarks);
 	}
 
 	tree_node* remove_node(unsigned int v, unsigned int state) // given a product graph node, delete its corresponding tree node from the node map and return the tree node pointer.
 	{
-		tree_node* ans = nullptr;
-		if (node_map.find(state) != node_map.end())
+		tree_node* ans = node_map.erase(merge_long_long(v, state));
+		if (ans)
 		{
-			if (node_map[state]->index.find(v) != node_map[state]->index.end())
-			{
-				ans = node_map[state]->index[v];
-				node_map[state]->index.erase(v);
-				node_cnt--;
-				landmarks.erase(static_cast<unsigned long long>(v) << 32 | state);
-				shrink(landmarks);
-				shrink(node_map[state]->index);
-				if (node_map[state]->index.empty())
-					node_map.erase(state);
-			}
+			node_cnt--;
+			landmarks.erase(static_cast<unsigned long long>(v) << 32 | state);
 		}
 		return ans;
 		
@@ -252,39 +406,153 @@ public:
 
 	void substitute_parent(tree_node* parent, tree_node* child)// change the parent pointer of child to the given parent
 	{
-		if (child->parent->child == child) child->parent->child = child->brother;
-		else {
-			tree_node* tmp = child->parent->child;
-			while (tmp != nullptr && tmp->brother != child) tmp = tmp->brother;
-			if (!tmp) {
-				cerr << "Error: child node not found in the child list of its parent." << endl;
-				exit(-1);
-			}
-			tmp->brother = child->brother;
-		}
-		child->parent = parent;
-		child->brother = parent->child;
-		parent->child = child;
+		unlink_child(child);
+		link_child(parent, child);
 	}
 
 	tree_node* find_node(unsigned int ID, unsigned int state) // given a product graph node, find its corresponding tree node
 	{
-		tree_node* result = nullptr;
-		if (node_map.find(state) != node_map.end()) {
-			if (node_map[state]->index.find(ID) != node_map[state]->index.end()) result = node_map[state]->index[ID];
+		return node_map.find(merge_long_long(ID, state));
+	}
+
+	void compact() // shrink the node map, TI map and landmark tables that lost most of their elements
+	{
+		shrink(node_map);
+		for (auto &states_index : time_info)
+			shrink(states_index.index);
+		shrink(landmarks);
+		shrink(timed_landmarks);
+	}
+
+	void measure_memory(memory_usage& m) const // charge the nodes reachable through the node map, the indexes and the landmark sets
+	{
+		m.node_maps += sizeof(RPQ_tree);
+		if constexpr (N == 0)
+			m.node_maps += memory_estimate::vector(time_info);
+		m.tree_nodes += node_map.size() * sizeof(tree_node);
+		m.node_maps += node_map.memory();
+		for (const auto &states_index : time_info)
+			m.node_maps += memory_estimate::hashed(states_index.index);
+		m.landmarks += memory_estimate::hashed(landmarks) + memory_estimate::hashed(timed_landmarks);
+	}
+
+	void save(CheckpointWriter& w) const // write the nodes in preorder with the position of their parent, then the indexes over them
+	{
+		vector<const tree_node*> nodes;
+		unordered_map<const tree_node*, unsigned int> pos;
+		vector<const tree_node*> stack;
+		if (root) stack.push_back(root);
+		while (!stack.empty())
+		{
+			const tree_node* tmp = stack.back();
+			stack.pop_back();
+			pos[tmp] = nodes.size();
+			nodes.push_back(tmp);
+			const size_t first_child = stack.size();
+			for (const tree_node* cur = tmp->child; cur; cur = cur->brother)
+				stack.push_back(cur);
+			reverse(stack.begin() + first_child, stack.end()); // visit children in list order
+		}
+		w.put_size(nodes.size());
+		for (const tree_node* tmp : nodes)
+		{
+			w.put(tmp->node_ID);
+			w.put(tmp->state);
+			w.put(tmp->timestamp);
+			w.put(tmp->edge_timestamp);
+			w.put(tmp->lm);
+			w.put(tmp->parent ? pos.at(tmp->parent) : UINT_MAX);
 		}
-		return result;
+		w.put(node_cnt);
+		vector<unsigned int> indexed; // positions of the nodes in the node map, which is keyed on their own vertex ID and state
+		node_map.for_each([&](const tree_node* node) {
+			if (auto it = pos.find(node); it != pos.end())
+				indexed.push_back(it->second);
+		});
+		w.put_vector(indexed);
+		w.put_size(count_if(time_info.begin(), time_info.end(), [](const time_info_index& i) { return !i.index.empty(); }));
+		for (unsigned int state = 0; state < time_info.size(); state++)
+		{
+			if (time_info[state].index.empty())
+				continue;
+			w.put(state);
+			w.put_map(time_info[state].index);
+		}
+		w.put_set(landmarks);
+		w.put_map(timed_landmarks);
 	}
 
+	void load(CheckpointReader& r) // inverse of save(), on an empty tree
+	{
+		const size_t n = r.get_size();
+		vector<tree_node*> nodes(n);
+		vector<tree_node*> last_child(n, nullptr);
+		for (size_t i = 0; i < n; i++)
+		{
+			const auto ID = r.get<unsigned int>();
+			const auto state = r.get<unsigned int>();
+			const auto time = r.get<unsigned int>();
+			const auto edge_time = r.get<unsigned int>();
+			nodes[i] = new tree_node(ID, state, time, edge_time);
+			nodes[i]->lm = r.get<bool>();
+			const auto parent = r.get<unsigned int>();
+			if (parent == UINT_MAX)
+				continue;
+			if (parent >= i)
+				r.fail("tree node listed before its parent");
+			nodes[i]->parent = nodes[parent];
+			nodes[i]->prev_brother = last_child[parent];
+			if (last_child[parent]) last_child[parent]->brother = nodes[i];
+			else nodes[parent]->child = nodes[i];
+			last_child[parent] = nodes[i];
+		}
+		root = n ? nodes[0] : nullptr;
+		r.get(node_cnt);
+		vector<unsigned int> indexed;
+		r.get_vector(indexed);
+		for (const unsigned int node : indexed)
+		{
+			if (node >= n) r.fail("tree node out of range");
+			node_slot(nodes[node]->node_ID, nodes[node]->state) = nodes[node];
+		}
+		for (size_t i = r.get_size(); i > 0; i--)
+		{
+			const auto state = r.get<unsigned int>();
+			if (state >= time_info.size()) r.fail("tree state out of range");
+			r.get_map(time_info[state].index);
+		}
+		r.get_set(landmarks);
+		r.get_map(timed_landmarks);
+	}
 
+private:
+	static void link_child(tree_node* parent, tree_node* child) // add child to the head of the child list of parent
+	{
+		child->parent = parent;
+		child->prev_brother = nullptr;
+		child->brother = parent->child;
+		if (parent->child)
+			parent->child->prev_brother = child;
+		parent->child = child;
+	}
+	static void unlink_child(tree_node* child) // split child from the child list of its parent in constant time; its own links are left to the caller
+	{
+		if (child->prev_brother)
+			child->prev_brother->brother = child->brother;
+		else
+			child->parent->child = child->brother;
+		if (child->brother)
+			child->brother->prev_brother = child->prev_brother;
+	}
 };
 
+template<unsigned int N>
 struct tree_info // structure for tree pointer list, used into the reverse map which maps product graph nodes to the spanning trees containing it.
 {
-	RPQ_tree* tree;
+	RPQ_tree<N>* tree;
 	tree_info* next;
 	tree_info* prev;
-	tree_info(RPQ_tree* t = nullptr)
+	tree_info(RPQ_tree<N>* t = nullptr)
 	{
 		tree = t;
 		next = nullptr;
@@ -378,20 +646,21 @@ inline bool operator>(const v2l_unit& v1, const v2l_unit& v2)
 	return false;
 }
 
+template<unsigned int N>
 class tree_info_index // reverse index from vertex ID to normal trees containing the product graph node. State of the product graph node is given in the upper layer. All product graph nodes in this index have the same state.
 {
 public:
-	unordered_map<unsigned int, tree_info*> tree_index; // map from vertex ID to normal trees
-	map<v2t_unit, tree_info*> info_map; // map from combination of vertex ID and tree root to the tree_info unit, used in deletion to quickly delete a reverse index unit.
+	unordered_map<unsigned int, tree_info<N>*> tree_index; // map from vertex ID to normal trees
+	map<v2t_unit, tree_info<N>*> info_map; // map from combination of vertex ID and tree root to the tree_info unit, used in deletion to quickly delete a reverse index unit.
 	tree_info_index() = default;
 	~tree_info_index()
 	{
 		for (auto & iter : tree_index)
 		{
-			tree_info* cur = iter.second;
+			tree_info<N>* cur = iter.second;
 			while (cur)
 			{
-				tree_info* tmp = cur;
+				tree_info<N>* tmp = cur;
 				cur = cur->next;
 				delete tmp;
 			}
@@ -399,20 +668,20 @@ public:
 		tree_index.clear();
 		info_map.clear();
 	}
-	void add_node(RPQ_tree* tree_pt, unsigned int v, unsigned int root_ID) // add a normal tree pointer + vertex ID to the reverse index
+	void add_node(RPQ_tree<N>* tree_pt, unsigned int v, unsigned int root_ID) // add a normal tree pointer + vertex ID to the reverse index
 	{
 		if (info_map.find(v2t_unit(v, root_ID)) != info_map.end())	// if the combination is already stored.
 			return;
 		auto iter = tree_index.find(v);
 		if (iter == tree_index.end())
 		{
-			auto* cur = new tree_info(tree_pt); //if there is no tree list before, add a new one
+			auto* cur = new tree_info<N>(tree_pt); //if there is no tree list before, add a new one
 			tree_index[v] = cur;
 			info_map[v2t_unit(v, root_ID)] = cur; // add this unit to the info_map
 		}
 		else
 		{
-			auto* cur = new tree_info(tree_pt);// If there is a tree lits, add the new tree_info to the head
+			auto* cur = new tree_info<N>(tree_pt);// If there is a tree lits, add the new tree_info to the head
 			cur->next = iter->second;
 			iter->second->prev = cur;
 			iter->second = cur;
@@ -420,12 +689,67 @@ public:
 		}
 	}
 
+	void compact()
+	{
+		shrink(tree_index);
+	}
+
+	size_t memory() const // one tree_info unit per info_map entry
+	{
+		return sizeof(tree_info_index) + memory_estimate::hashed(tree_index) + memory_estimate::ordered(info_map) + info_map.size() * sizeof(tree_info<N>);
+	}
+
+	void save(CheckpointWriter& w, const unordered_map<const RPQ_tree<N>*, unsigned long long>& tree_keys) const // tree lists in order; each entry as forest key + tree root
+	{
+		unordered_map<const tree_info<N>*, unsigned int> roots;
+		for (const auto &[unit, info] : info_map)
+			roots[info] = unit.tree_root;
+		w.put_size(tree_index.size());
+		for (const auto &[v, head] : tree_index)
+		{
+			w.put(v);
+			size_t len = 0;
+			for (const tree_info<N>* cur = head; cur; cur = cur->next)
+				len += tree_keys.count(cur->tree);
+			w.put_size(len);
+			for (const tree_info<N>* cur = head; cur; cur = cur->next)
+			{
+				if (auto it = tree_keys.find(cur->tree); it != tree_keys.end())
+				{
+					w.put(it->second);
+					w.put(roots.at(cur));
+				}
+			}
+		}
+	}
+
+	void load(CheckpointReader& r, const unordered_map<unsigned long long, RPQ_tree<N>*>& forests)
+	{
+		for (size_t i = r.get_size(); i > 0; i--)
+		{
+			const auto v = r.get<unsigned int>();
+			tree_info<N>* prev = nullptr;
+			for (size_t j = r.get_size(); j > 0; j--)
+			{
+				const auto key = r.get<unsigned long long>();
+				const auto root_ID = r.get<unsigned int>();
+				auto it = forests.find(key);
+				if (it == forests.end()) r.fail("reverse index refers to a missing tree");
+				auto* cur = new tree_info<N>(it->second);
+				if (prev) { prev->next = cur; cur->prev = prev; }
+				else tree_index[v] = cur;
+				info_map[v2t_unit(v, root_ID)] = cur;
+				prev = cur;
+			}
+		}
+	}
+
 	void delete_node(unsigned int v, unsigned int root_ID) // delete a tree info unit given the vertex ID -tree root pair, used when a node is deleted from a normal tree.
 	{
 		if (info_map.find(v2t_unit(v, root_ID)) != info_map.end()) // use the info_map to find the unit without scanning the list. 
 		{
 			auto iter = info_map.find(v2t_unit(v, root_ID));
-			tree_info* cur = iter->second;
+			tree_info<N>* cur = iter->second;
 			if (cur->prev) // if this unit is not the head of the tree list 
 			{
 				cur->prev->next = cur->next;
@@ -444,7 +768,6 @@ public:
 					}
 					else {
 						tree_index.erase(iterator); // if the tree list is empty;
-						shrink(tree_index);
 					}
 				}
 			}
@@ -455,20 +778,21 @@ public:
 };
 
 
+template<unsigned int N>
 class lm_info_index // similar to the tree_info_index, but is used for LM trees. All the functions are also similar.
 {
 public:
-	unordered_map<unsigned int, tree_info*> tree_index;
-	map<v2l_unit, tree_info*> info_map;
+	unordered_map<unsigned int, tree_info<N>*> tree_index;
+	map<v2l_unit, tree_info<N>*> info_map;
 	lm_info_index() = default;
 	~lm_info_index()
 	{
 		for (auto &[fst, snd] : tree_index)
 		{
-			tree_info* cur = snd;
+			tree_info<N>* cur = snd;
 			while (cur)
 			{
-				tree_info* tmp = cur;
+				tree_info<N>* tmp = cur;
 				cur = cur->next;
 				delete tmp;
 			}
@@ -476,19 +800,19 @@ public:
 		tree_index.clear();
 		info_map.clear();
 	}
-	void add_node(RPQ_tree* tree_pt, unsigned int v, unsigned int root_ID, unsigned int root_state)
+	void add_node(RPQ_tree<N>* tree_pt, unsigned int v, unsigned int root_ID, unsigned int root_state)
 	{
 		if (info_map.find(v2l_unit(v, root_ID, root_state)) != info_map.end())
 			return;
 		if (auto iter = tree_index.find(v); iter == tree_index.end())
 		{
-			auto* cur = new tree_info(tree_pt);
+			auto* cur = new tree_info<N>(tree_pt);
 			tree_index[v] = cur;
 			info_map[v2l_unit(v, root_ID, root_state)] = cur;
 		}
 		else
 		{
-			auto* cur = new tree_info(tree_pt);
+			auto* cur = new tree_info<N>(tree_pt);
 			cur->next = iter->second;
 			iter->second->prev = cur;
 			iter->second = cur;
@@ -496,12 +820,69 @@ public:
 		}
 	}
 
+	void compact()
+	{
+		shrink(tree_index);
+	}
+
+	size_t memory() const
+	{
+		return sizeof(lm_info_index) + memory_estimate::hashed(tree_index) + memory_estimate::ordered(info_map) + info_map.size() * sizeof(tree_info<N>);
+	}
+
+	void save(CheckpointWriter& w, const unordered_map<const RPQ_tree<N>*, unsigned long long>& tree_keys) const
+	{
+		unordered_map<const tree_info<N>*, const v2l_unit*> units;
+		for (const auto &[unit, info] : info_map)
+			units[info] = &unit;
+		w.put_size(tree_index.size());
+		for (const auto &[v, head] : tree_index)
+		{
+			w.put(v);
+			size_t len = 0;
+			for (const tree_info<N>* cur = head; cur; cur = cur->next)
+				len += tree_keys.count(cur->tree);
+			w.put_size(len);
+			for (const tree_info<N>* cur = head; cur; cur = cur->next)
+			{
+				if (auto it = tree_keys.find(cur->tree); it != tree_keys.end())
+				{
+					w.put(it->second);
+					w.put(units.at(cur)->root_ID);
+					w.put(units.at(cur)->root_state);
+				}
+			}
+		}
+	}
+
+	void load(CheckpointReader& r, const unordered_map<unsigned long long, RPQ_tree<N>*>& forests)
+	{
+		for (size_t i = r.get_size(); i > 0; i--)
+		{
+			const auto v = r.get<unsigned int>();
+			tree_info<N>* prev = nullptr;
+			for (size_t j = r.get_size(); j > 0; j--)
+			{
+				const auto key = r.get<unsigned long long>();
+				const auto root_ID = r.get<unsigned int>();
+				const auto root_state = r.get<unsigned int>();
+				auto it = forests.find(key);
+				if (it == forests.end()) r.fail("reverse index refers to a missing tree");
+				auto* cur = new tree_info<N>(it->second);
+				if (prev) { prev->next = cur; cur->prev = prev; }
+				else tree_index[v] = cur;
+				info_map[v2l_unit(v, root_ID, root_state)] = cur;
+				prev = cur;
+			}
+		}
+	}
+
 	void delete_node(unsigned int v, unsigned int root_ID, unsigned int root_state)
 	{
 		if (info_map.find(v2l_unit(v, root_ID, root_state)) != info_map.end())
 		{
 			auto iter = info_map.find(v2l_unit(v, root_ID, root_state));
-			tree_info* cur = iter->second;
+			tree_info<N>* cur = iter->second;
 			if (cur->prev)
 			{
 				cur->prev->next = cur->next;
@@ -520,7 +901,6 @@ public:
 					}
 					else {
 						tree_index.erase(iterator);
-						shrink(tree_index);
 					}
 				}
 			}
@@ -575,3 +955,97 @@ struct pair_compare
 		return p1.second<p2.second;
 	}
 };
+
+// checkpoint helpers shared by S-PATH and LM-SRPQ: the forest map, then the reverse indexes that point into it
+
+template<unsigned int N>
+void save_forests(CheckpointWriter& w, const unordered_map<unsigned long long, RPQ_tree<N>*>& forests)
+{
+	w.put_size(forests.size());
+	for (const auto &[key, tree] : forests)
+	{
+		w.put(key);
+		tree->save(w);
+	}
+}
+
+template<unsigned int N>
+void load_forests(CheckpointReader& r, unordered_map<unsigned long long, RPQ_tree<N>*>& forests, unsigned int states)
+{
+	const size_t n = r.get_size();
+	forests.reserve(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		const auto key = r.get<unsigned long long>();
+		auto* tree = new RPQ_tree<N>(states);
+		tree->load(r);
+		forests[key] = tree;
+	}
+}
+
+template<unsigned int N>
+unordered_map<const RPQ_tree<N>*, unsigned long long> forest_keys(const unordered_map<unsigned long long, RPQ_tree<N>*>& forests)
+{
+	unordered_map<const RPQ_tree<N>*, unsigned long long> keys;
+	keys.reserve(forests.size());
+	for (const auto &[key, tree] : forests)
+		keys[tree] = key;
+	return keys;
+}
+
+template<typename Index, unsigned int N>
+void save_reverse_index(CheckpointWriter& w, const map<unsigned int, Index*>& index, const unordered_map<const RPQ_tree<N>*, unsigned long long>& keys)
+{
+	w.put_size(index.size());
+	for (const auto &[state, states_index] : index)
+	{
+		w.put(state);
+		states_index->save(w, keys);
+	}
+}
+
+template<typename Index, unsigned int N>
+void load_reverse_index(CheckpointReader& r, map<unsigned int, Index*>& index, const unordered_map<unsigned long long, RPQ_tree<N>*>& forests)
+{
+	for (size_t i = r.get_size(); i > 0; i--)
+	{
+		auto* states_index = new Index;
+		index[r.get<unsigned int>()] = states_index;
+		states_index->load(r, forests);
+	}
+}
+
+template<unsigned int N>
+void measure_forests(memory_usage& m, const unordered_map<unsigned long long, RPQ_tree<N>*>& forests)
+{
+	m.node_maps += memory_estimate::hashed(forests);
+	for (const auto &[key, tree] : forests)
+		tree->measure_memory(m);
+}
+
+template<typename Index>
+size_t reverse_index_memory(const map<unsigned int, Index*>& index)
+{
+	size_t total = memory_estimate::ordered(index);
+	for (const auto &[state, states_index] : index)
+		total += states_index->memory();
+	return total;
+}
+
+template<unsigned int N>
+void compact_forests(unordered_map<unsigned long long, RPQ_tree<N>*>& forests, unordered_set<unsigned long long>& touched) // called once per slide, after expiration.
+// touched holds the roots of the trees that lost entries since the last call; only those are compacted, and touched is emptied.
+{
+	shrink(forests);
+	for (unsigned long long key : touched)
+		if (auto it = forests.find(key); it != forests.end())
+			it->second->compact();
+	touched.clear();
+}
+
+template<typename Index>
+void compact_reverse_index(map<unsigned int, Index*>& index)
+{
+	for (auto &[state, states_index] : index)
+		states_index->compact();
+}
@@ -2,12 +2,14 @@
 #ifndef FSA_H
 #define FSA_H
 
+#include <algorithm>
 #include <iostream>
-#include <map>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "query_compiler.h"
+
 class FiniteStateAutomaton {
 public:
     struct Transition {
@@ -20,7 +22,7 @@ public:
     long long initialState;
     std::unordered_set<long long> finalStates;
     int states_count = 0;
-    unsigned int scores[4]{};
+    std::vector<unsigned int> scores = std::vector<unsigned int>(4); // LM-SRPQ landmark score per state
     
     FiniteStateAutomaton(long long query_type, const std::vector<long long> &labels) : initialState(0) {
         switch (query_type) {
@@ -104,22 +106,87 @@ public:
                 scores[1] = 13;  /// 2 loops, 1 edge 1->2, thus 2*6+1 = 13
                 scores[2] = 6;
                 break;
-            case 8: // (a|b)+c
-                addFinalState(3);
-                addTransition(0,1, labels[0]);
-                addTransition(0,2,labels[1]);
-                addTransition(1,2, labels[1]);
-                addTransition(2,1, labels[0]);
-                addTransition(2,2,labels[1]);
-                addTransition(1,1, labels[0]);
-                addTransition(1,3, labels[2]);
-                addTransition(2,3,labels[2]);
-                states_count = 4;
+            case 8: { // (a|b)+c, whose two loop states the compiler merges into one
+                query_automaton q;
+                if (std::string error; !QueryCompiler::compile("(" + std::to_string(labels[0]) + "|" + std::to_string(labels[1]) + ")+/" +
+                                                               std::to_string(labels[2]), {}, q, error)) {
+                    std::cerr << "ERROR: query type 8: " << error << std::endl;
+                    exit(1);
+                }
+                load(q);
+                scores.assign(scores.size(), 0); // the hand-written automaton had no scores, so LM-SRPQ selects no landmarks
                 break;
+            }
             default:
                 std::cerr << "ERROR: Wrong query type" << std::endl;
                 exit(1);
         }
+        compile();
+    }
+
+    // Automaton of a `query` expression, see QueryCompiler. An expression that
+    // spells a built-in query takes its scores, so that LM-SRPQ runs it the
+    // same way as the query_type.
+    explicit FiniteStateAutomaton(const query_automaton &q) : initialState(0) {
+        load(q);
+        for (const long long query_type : builtin_query_types) {
+            if (adoptScores(FiniteStateAutomaton(query_type, {0, 1, 2}))) break;
+        }
+        compile();
+    }
+
+    // Builds the tables the lookups below read; call again after adding
+    // transitions. Labels are small non-negative IDs, like the per-label
+    // vectors of the graph and the mode context assume.
+    void compile() {
+        long long max_label = -1;
+        for (const auto &[from, out] : transitions) {
+            for (const Transition &t : out) {
+                if (t.label < 0) {
+                    std::cerr << "Error: labels should be >= 0" << std::endl;
+                    exit(1);
+                }
+                max_label = std::max(max_label, t.label);
+                states_ = std::max(states_, static_cast<int>(std::max(t.fromState, t.toState)) + 1);
+            }
+        }
+        states_ = std::max(states_, states_count);
+
+        // dense label IDs in first-seen order; the pairs keep the order of transitions
+        label_ids_.assign(max_label + 1, -1);
+        pairs_.clear();
+        for (const auto &[from, out] : transitions) {
+            for (const Transition &t : out) {
+                if (label_ids_[t.label] < 0) {
+                    label_ids_[t.label] = static_cast<int>(pairs_.size());
+                    pairs_.emplace_back();
+                }
+                pairs_[label_ids_[t.label]].emplace_back(t.fromState, t.toState);
+            }
+        }
+
+        // the first transition of a state on a label wins, as in a scan of its transitions
+        next_.assign(static_cast<std::size_t>(states_) * pairs_.size(), -1);
+        labels_from_.assign(states_, {});
+        labels_into_.assign(states_, {});
+        for (const auto &[from, out] : transitions) {
+            for (const Transition &t : out) {
+                long long &next = next_[from * pairs_.size() + label_ids_[t.label]];
+                if (next != -1) continue;
+                next = t.toState;
+                labels_from_[from].emplace_back(t.label, t.toState);
+            }
+        }
+        for (const auto &[from, out] : transitions) {
+            for (const Transition &t : out) {
+                std::vector<long long> &into = labels_into_[t.toState];
+                if (std::find(into.begin(), into.end(), t.label) == into.end()) into.push_back(t.label);
+            }
+        }
+        final_.assign(states_, false);
+        for (const long long state : finalStates) {
+            if (state >= 0 && state < states_) final_[state] = true;
+        }
     }
     
     void addTransition(long long fromState, long long toState, long long label) {
@@ -160,48 +227,46 @@ public:
         return initialTransitionLabels;
     }
     
-    [[nodiscard]] std::vector<std::pair<long long, long long> > getStatePairsWithTransition(long long label) const {
-        std::vector<std::pair<long long, long long> > statePairs;
-        for (const auto& pair : transitions) {
-            for (const auto& transition : pair.second) {
-                if (transition.label == label) {
-                    statePairs.emplace_back(transition.fromState, transition.toState);
-                }
-            }
-        }
-        return statePairs;
+    // (fromState, toState) of every transition on label.
+    [[nodiscard]] const std::vector<std::pair<long long, long long> > &getStatePairsWithTransition(const long long label) const {
+        const int id = labelId(label);
+        return id < 0 ? no_pairs_ : pairs_[id];
     }
-    
-    long long getNextState(const long long currentState, const long long label) {
-        for (const auto& transition : transitions[currentState]) {
-            if (transition.label == label) {
-                return transition.toState;
-            }
-        }
-        return -1; // No valid transition
+
+    [[nodiscard]] long long getNextState(const long long currentState, const long long label) const {
+        const int id = labelId(label);
+        if (id < 0 || currentState < 0 || currentState >= states_) return -1; // No valid transition
+        return next_[currentState * pairs_.size() + id];
     }
-    
-    std::map<long long, long long> getAllSuccessors(const long long state) {
-        std::map<long long, long long> successors;
-        for (const auto& transition : transitions[state]) {
-            successors[transition.label] = transition.toState;
-        }
-        return successors;
+
+    // Calls f(label, toState) once per label leaving state, with the state
+    // getNextState(state, label) returns; expansions use it to visit only the
+    // matching label partitions of the graph.
+    template<typename F>
+    void forEachLabelFrom(const long long state, F &&f) const {
+        if (state < 0 || state >= states_) return;
+        for (const auto &[label, to] : labels_from_[state]) f(label, to);
     }
 
+    // Calls f(label) once per label of the transitions entering state.
+    template<typename F>
+    void forEachLabelInto(const long long state, F &&f) const {
+        if (state < 0 || state >= states_) return;
+        for (const long long label : labels_into_[state]) f(label);
+    }
+
+    // True if some transition reads label; the ingest filter drops the other edges.
     [[nodiscard]] bool hasLabel(const long long label) const {
-        for (const auto&[fst, snd] : transitions) {
-            for (const auto& transition : snd) {
-                if (transition.label == label) {
-                    return true;
-                }
-            }
-        }
-        return false;
+        return labelId(label) >= 0;
+    }
+
+    // Number of states; every state the lookups return is below it.
+    [[nodiscard]] int states() const {
+        return states_;
     }
 
     [[nodiscard]] bool isFinalState(const long long state) const {
-        return finalStates.find(state) != finalStates.end();
+        return state >= 0 && state < states_ && final_[state];
     }
     
     void printTransitions() const {
@@ -211,6 +276,72 @@ public:
             }
         }
     }
+
+private:
+    static constexpr long long builtin_query_types[] = {1, 2, 3, 4, 5, 6, 7, 8, 10};
+
+    // compiled form of transitions and finalStates, see compile()
+    int states_ = 0;
+    std::vector<int> label_ids_;                                  // label -> dense label ID, -1: no transition reads it
+    std::vector<std::vector<std::pair<long long, long long> > > pairs_; // dense label -> (fromState, toState)
+    std::vector<long long> next_;                                 // state * labels + dense label -> next state, -1: none
+    std::vector<std::vector<std::pair<long long, long long> > > labels_from_; // state -> (label, next state)
+    std::vector<std::vector<long long> > labels_into_;            // state -> distinct labels entering it
+    std::vector<bool> final_;
+    const std::vector<std::pair<long long, long long> > no_pairs_;
+
+    void load(const query_automaton &q) {
+        for (const auto &[from, to, label] : q.transitions) addTransition(from, to, label);
+        for (const long long state : q.finals) addFinalState(state);
+        states_count = q.states;
+        scores = q.scores;
+    }
+
+    // Copies the scores of other if both automata are equal up to the numbering
+    // of the states (the initial state stays 0) and a renaming of the labels.
+    bool adoptScores(const FiniteStateAutomaton &other) {
+        std::vector<Transition> own, others;
+        std::vector<long long> own_labels, other_labels;
+        for (const auto &[from, out] : transitions) own.insert(own.end(), out.begin(), out.end());
+        for (const auto &[from, out] : other.transitions) others.insert(others.end(), out.begin(), out.end());
+        for (const Transition &t : own) {
+            if (std::find(own_labels.begin(), own_labels.end(), t.label) == own_labels.end()) own_labels.push_back(t.label);
+        }
+        for (const Transition &t : others) {
+            if (std::find(other_labels.begin(), other_labels.end(), t.label) == other_labels.end()) other_labels.push_back(t.label);
+        }
+        if (states_count != other.states_count || own.size() != others.size() ||
+            finalStates.size() != other.finalStates.size() || own_labels.size() != other_labels.size()) return false;
+
+        std::vector<long long> state_map(states_count); // own state -> state of other
+        for (long long i = 0; i < states_count; i++) state_map[i] = i;
+        std::sort(other_labels.begin(), other_labels.end());
+        do {
+            if (state_map[initialState] != other.initialState) continue;
+            const bool same_finals = std::all_of(finalStates.begin(), finalStates.end(), [&](const long long f) {
+                return other.finalStates.count(state_map[f]) != 0;
+            });
+            if (!same_finals) continue;
+            std::vector<long long> label_map = other_labels; // own_labels[i] -> label_map[i]
+            do {
+                const bool same_transitions = std::all_of(own.begin(), own.end(), [&](const Transition &t) {
+                    const long long label = label_map[std::find(own_labels.begin(), own_labels.end(), t.label) - own_labels.begin()];
+                    return std::any_of(others.begin(), others.end(), [&](const Transition &o) {
+                        return o.fromState == state_map[t.fromState] && o.toState == state_map[t.toState] && o.label == label;
+                    });
+                });
+                if (!same_transitions) continue;
+                scores.assign(other.scores.size(), 0);
+                for (long long i = 0; i < states_count; i++) scores[i] = other.scores[state_map[i]];
+                return true;
+            } while (std::next_permutation(label_map.begin(), label_map.end()));
+        } while (std::next_permutation(state_map.begin(), state_map.end()));
+        return false;
+    }
+
+    [[nodiscard]] int labelId(const long long label) const {
+        return label >= 0 && label < static_cast<long long>(label_ids_.size()) ? label_ids_[label] : -1;
+    }
 };
 
 #endif //FSA_H
@@ -0,0 +1,156 @@
+#ifndef ADA_BINARY_EDGE_READER_H
+#define ADA_BINARY_EDGE_READER_H
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "byte_source.h"
+#include "edge_reader.h"
+
+// Binary edge-stream format (all fixed-width fields little-endian).
+//
+//   offset  size    field
+//   0       4       magic "ADAE"
+//   4       2       version (1)
+//   6       2       flags (reserved, 0)
+//   8       8       t_origin: int64 timestamp the first time delta refers to
+//   16      8       record_count: uint64, 0 if unknown
+//   24      4       label_count: uint32
+//   28      8 * n   label dictionary: int64 label value for each label index
+//   ...             records
+//
+// Each record is four LEB128 varints: zigzag(s), zigzag(d), label index,
+// zigzag(t - t_prev), where t_prev is the timestamp of the previous record
+// (t_origin for the first one). Produced from text streams by
+// scripts/dataset_preprocess/convert_to_binary.py.
+namespace binary_edge_format {
+    constexpr char magic[4] = {'A', 'D', 'A', 'E'};
+    constexpr std::uint16_t version = 1;
+    constexpr std::size_t header_size = 28;
+    constexpr std::size_t max_record_size = 4 * 10; // four 64-bit varints
+
+    inline long long unzigzag(const std::uint64_t v) {
+        return static_cast<long long>((v >> 1) ^ (~(v & 1) + 1));
+    }
+
+    template<typename T>
+    T load_le(const unsigned char *p) {
+        std::uint64_t v = 0;
+        for (std::size_t i = 0; i < sizeof(T); i++) v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+        return static_cast<T>(v);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// BinaryEdgeReader  —  decodes the varint/delta format above
+// ---------------------------------------------------------------------------
+class BinaryEdgeReader final : public EdgeReader {
+    static constexpr std::size_t buffer_size = 1 << 16;
+
+    std::unique_ptr<ByteSource> source_;
+    std::vector<unsigned char> buffer_;
+    std::size_t pos_ = 0;
+    std::size_t end_ = 0;
+    bool eof_ = false;
+    bool valid_ = false;
+
+    std::vector<long long> labels_;
+    long long t_prev_ = 0;
+    std::uint64_t record_count_ = 0;
+
+    // Keep at least `want` bytes buffered unless the file ends first.
+    bool fill(const std::size_t want) {
+        if (end_ - pos_ >= want) return true;
+        if (eof_) return end_ > pos_;
+        std::memmove(buffer_.data(), buffer_.data() + pos_, end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+        while (end_ < buffer_.size() && !eof_) {
+            const std::size_t got = source_->read(reinterpret_cast<char *>(buffer_.data()) + end_, buffer_.size() - end_);
+            if (got == 0) eof_ = true;
+            end_ += got;
+        }
+        return end_ > pos_;
+    }
+
+    bool read_varint(std::uint64_t &out) {
+        out = 0;
+        for (int shift = 0; shift < 64 && pos_ < end_; shift += 7) {
+            const unsigned char byte = buffer_[pos_++];
+            out |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool read_header(const std::string &path) {
+        namespace fmt = binary_edge_format;
+        if (!fill(fmt::header_size)) return false;
+        if (end_ - pos_ < fmt::header_size || std::memcmp(buffer_.data() + pos_, fmt::magic, 4) != 0) {
+            std::cerr << "Error: " << path << " is not a binary edge stream" << std::endl;
+            return false;
+        }
+        const unsigned char *h = buffer_.data() + pos_;
+        if (const auto v = fmt::load_le<std::uint16_t>(h + 4); v != fmt::version) {
+            std::cerr << "Error: unsupported binary edge stream version " << v << std::endl;
+            return false;
+        }
+        t_prev_ = fmt::load_le<long long>(h + 8);
+        record_count_ = fmt::load_le<std::uint64_t>(h + 16);
+        const auto label_count = fmt::load_le<std::uint32_t>(h + 24);
+        pos_ += fmt::header_size;
+
+        labels_.resize(label_count);
+        for (auto &label : labels_) {
+            if (!fill(8) || end_ - pos_ < 8) {
+                std::cerr << "Error: truncated label dictionary in " << path << std::endl;
+                return false;
+            }
+            label = fmt::load_le<long long>(buffer_.data() + pos_);
+            pos_ += 8;
+        }
+        return true;
+    }
+
+public:
+    // path is only used in error messages
+    BinaryEdgeReader(std::unique_ptr<ByteSource> source, const std::string &path)
+        : source_(std::move(source)), buffer_(buffer_size) {
+        if (source_->is_open()) valid_ = read_header(path);
+    }
+
+    [[nodiscard]] bool is_open() const override {
+        return valid_;
+    }
+
+    [[nodiscard]] std::uint64_t record_count() const {
+        return record_count_;
+    }
+
+    bool next(stream_edge &e) override {
+        if (!valid_ || !fill(binary_edge_format::max_record_size)) return false;
+        std::uint64_t s, d, label, dt;
+        if (!read_varint(s) || !read_varint(d) || !read_varint(label) || !read_varint(dt)) {
+            std::cerr << "Error: truncated record in binary edge stream" << std::endl;
+            valid_ = false;
+            return false;
+        }
+        if (label >= labels_.size()) {
+            std::cerr << "Error: label index " << label << " outside the label dictionary" << std::endl;
+            valid_ = false;
+            return false;
+        }
+        t_prev_ += binary_edge_format::unzigzag(dt);
+        e.s = binary_edge_format::unzigzag(s);
+        e.d = binary_edge_format::unzigzag(d);
+        e.l = labels_[label];
+        e.t = t_prev_;
+        return true;
+    }
+};
+
+#endif //ADA_BINARY_EDGE_READER_H
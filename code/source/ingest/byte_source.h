@@ -0,0 +1,218 @@
+#ifndef ADA_BYTE_SOURCE_H
+#define ADA_BYTE_SOURCE_H
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef ADA_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ADA_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// ByteSource  —  sequential bytes of an input file, decompressed on the fly
+//
+// Compressed inputs are recognised by their magic number. gzip and zstd are
+// decoded in-process when built with -DADA_WITH_ZLIB (-lz) / -DADA_WITH_ZSTD
+// (-lzstd); otherwise the stream is piped through `gzip -dc` / `zstd -dc`.
+// Either way only a small fixed buffer of decompressed data is held.
+// ---------------------------------------------------------------------------
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    [[nodiscard]] virtual bool is_open() const = 0;
+
+    // Reads up to n bytes into buf; returns 0 only at end of stream or on error.
+    virtual std::size_t read(char *buf, std::size_t n) = 0;
+};
+
+enum class Compression { none, gzip, zstd };
+
+inline Compression detect_compression(const std::string &path) {
+    unsigned char magic[4] = {};
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return Compression::none;
+    const std::size_t got = std::fread(magic, 1, sizeof(magic), f);
+    std::fclose(f);
+    if (got >= 2 && magic[0] == 0x1F && magic[1] == 0x8B) return Compression::gzip;
+    if (got >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        return Compression::zstd;
+    return Compression::none;
+}
+
+class FileByteSource final : public ByteSource {
+    std::FILE *file_;
+
+public:
+    explicit FileByteSource(const std::string &path) : file_(std::fopen(path.c_str(), "rb")) {}
+
+    ~FileByteSource() override {
+        if (file_) std::fclose(file_);
+    }
+
+    FileByteSource(const FileByteSource &) = delete;
+    FileByteSource &operator=(const FileByteSource &) = delete;
+
+    [[nodiscard]] bool is_open() const override {
+        return file_ != nullptr;
+    }
+
+    std::size_t read(char *buf, const std::size_t n) override {
+        return file_ ? std::fread(buf, 1, n, file_) : 0;
+    }
+};
+
+// Output of an external decompressor, e.g. "gzip -dc".
+class PipeByteSource final : public ByteSource {
+    std::string command_;
+    std::FILE *pipe_;
+
+    void close_pipe() {
+        if (!pipe_) return;
+        if (const int status = pclose(pipe_); status != 0)
+            std::cerr << "Error: `" << command_ << "` exited with status " << status << std::endl;
+        pipe_ = nullptr;
+    }
+
+public:
+    PipeByteSource(const std::string &tool, const std::string &path) {
+        // single-quote the path for the shell, escaping embedded quotes
+        std::string quoted = "'";
+        for (const char c : path) quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        quoted += "'";
+        command_ = tool + " -dc -- " + quoted;
+        pipe_ = popen(command_.c_str(), "r");
+    }
+
+    ~PipeByteSource() override {
+        close_pipe();
+    }
+
+    PipeByteSource(const PipeByteSource &) = delete;
+    PipeByteSource &operator=(const PipeByteSource &) = delete;
+
+    [[nodiscard]] bool is_open() const override {
+        return pipe_ != nullptr;
+    }
+
+    std::size_t read(char *buf, const std::size_t n) override {
+        if (!pipe_) return 0;
+        const std::size_t got = std::fread(buf, 1, n, pipe_);
+        if (got == 0) close_pipe();
+        return got;
+    }
+};
+
+#ifdef ADA_WITH_ZLIB
+class GzipByteSource final : public ByteSource {
+    gzFile file_;
+
+public:
+    explicit GzipByteSource(const std::string &path) : file_(gzopen(path.c_str(), "rb")) {
+        if (file_) gzbuffer(file_, 1 << 16);
+    }
+
+    ~GzipByteSource() override {
+        if (file_) gzclose(file_);
+    }
+
+    GzipByteSource(const GzipByteSource &) = delete;
+    GzipByteSource &operator=(const GzipByteSource &) = delete;
+
+    [[nodiscard]] bool is_open() const override {
+        return file_ != nullptr;
+    }
+
+    std::size_t read(char *buf, const std::size_t n) override {
+        if (!file_) return 0;
+        const int got = gzread(file_, buf, static_cast<unsigned>(n));
+        if (got < 0) {
+            int err;
+            std::cerr << "Error: gzip stream: " << gzerror(file_, &err) << std::endl;
+            return 0;
+        }
+        return static_cast<std::size_t>(got);
+    }
+};
+#endif
+
+#ifdef ADA_WITH_ZSTD
+class ZstdByteSource final : public ByteSource {
+    std::FILE *file_;
+    ZSTD_DCtx *ctx_;
+    std::vector<char> in_;
+    ZSTD_inBuffer input_{nullptr, 0, 0};
+    bool failed_ = false;
+
+public:
+    explicit ZstdByteSource(const std::string &path)
+        : file_(std::fopen(path.c_str(), "rb")), ctx_(ZSTD_createDCtx()), in_(ZSTD_DStreamInSize()) {
+        input_.src = in_.data();
+    }
+
+    ~ZstdByteSource() override {
+        if (file_) std::fclose(file_);
+        ZSTD_freeDCtx(ctx_);
+    }
+
+    ZstdByteSource(const ZstdByteSource &) = delete;
+    ZstdByteSource &operator=(const ZstdByteSource &) = delete;
+
+    [[nodiscard]] bool is_open() const override {
+        return file_ != nullptr && ctx_ != nullptr;
+    }
+
+    std::size_t read(char *buf, const std::size_t n) override {
+        if (!is_open() || failed_) return 0;
+        ZSTD_outBuffer output{buf, n, 0};
+        while (output.pos == 0) {
+            bool eof = false;
+            if (input_.pos == input_.size) {
+                input_.size = std::fread(in_.data(), 1, in_.size(), file_);
+                input_.pos = 0;
+                eof = input_.size == 0;
+            }
+            // with no input left this only flushes what the decoder still holds
+            const std::size_t ret = ZSTD_decompressStream(ctx_, &output, &input_);
+            if (ZSTD_isError(ret)) {
+                std::cerr << "Error: zstd stream: " << ZSTD_getErrorName(ret) << std::endl;
+                failed_ = true;
+                break;
+            }
+            if (eof && output.pos == 0) {
+                if (ret != 0) std::cerr << "Error: truncated zstd stream" << std::endl;
+                break;
+            }
+        }
+        return output.pos;
+    }
+};
+#endif
+
+inline std::unique_ptr<ByteSource> open_byte_source(const std::string &path) {
+    switch (detect_compression(path)) {
+        case Compression::gzip:
+#ifdef ADA_WITH_ZLIB
+            return std::make_unique<GzipByteSource>(path);
+#else
+            return std::make_unique<PipeByteSource>("gzip", path);
+#endif
+        case Compression::zstd:
+#ifdef ADA_WITH_ZSTD
+            return std::make_unique<ZstdByteSource>(path);
+#else
+            return std::make_unique<PipeByteSource>("zstd", path);
+#endif
+        default:
+            return std::make_unique<FileByteSource>(path);
+    }
+}
+
+#endif //ADA_BYTE_SOURCE_H
@@ -0,0 +1,68 @@
+#ifndef ADA_EDGE_READER_H
+#define ADA_EDGE_READER_H
+
+#include <cstdint>
+#include <memory>
+
+// One raw edge as it appears in the input stream, before t0 rebasing and
+// label filtering (both done by EdgePrefilter, see edge_source.h).
+struct stream_edge {
+    long long s;
+    long long d;
+    long long l;
+    long long t;
+};
+
+// ---------------------------------------------------------------------------
+// EdgeReader  —  common interface for all input formats
+// ---------------------------------------------------------------------------
+class EdgeReader {
+public:
+    virtual ~EdgeReader() = default;
+
+    // False if the input could not be opened or its header is invalid.
+    [[nodiscard]] virtual bool is_open() const = 0;
+
+    // Read the next edge; returns false at end of stream.
+    virtual bool next(stream_edge &e) = 0;
+
+    // False if next() may block waiting for a producer (live inputs only).
+    [[nodiscard]] virtual bool ready() const {
+        return true;
+    }
+
+    // Discards the next n records (resuming from a checkpoint); returns how
+    // many were there.
+    virtual std::uint64_t skip(const std::uint64_t n) {
+        stream_edge e{};
+        std::uint64_t skipped = 0;
+        while (skipped < n && next(e)) skipped++;
+        return skipped;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// DeltaTimeEdgeReader  —  `time_encoding=delta`: the t column of the wrapped
+// stream holds the difference to the previous record's timestamp (the first
+// record's t is absolute)
+// ---------------------------------------------------------------------------
+class DeltaTimeEdgeReader final : public EdgeReader {
+    std::unique_ptr<EdgeReader> inner_;
+    long long t_prev_ = 0;
+
+public:
+    explicit DeltaTimeEdgeReader(std::unique_ptr<EdgeReader> inner) : inner_(std::move(inner)) {}
+
+    [[nodiscard]] bool is_open() const override {
+        return inner_->is_open();
+    }
+
+    bool next(stream_edge &e) override {
+        if (!inner_->next(e)) return false;
+        t_prev_ += e.t;
+        e.t = t_prev_;
+        return true;
+    }
+};
+
+#endif //ADA_EDGE_READER_H
@@ -0,0 +1,68 @@
+#ifndef ADA_EDGE_READER_FACTORY_H
+#define ADA_EDGE_READER_FACTORY_H
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "byte_source.h"
+#include "edge_reader.h"
+#include "text_edge_reader.h"
+#include "binary_edge_reader.h"
+#include "mmap_text_reader.h"
+#include "stream_server_reader.h"
+
+// ---------------------------------------------------------------------------
+// EdgeReaderFactory  —  maps the `input_format` config key to a reader
+//
+//   text    →  TextEdgeReader   ("s d l t" per line)
+//   mmap    →  MmapTextEdgeReader (same text format, memory-mapped)
+//   binary  →  BinaryEdgeReader (see binary_edge_reader.h)
+//   socket  →  StreamServerReader on a Unix domain socket (live frames)
+//   fifo    →  StreamServerReader on a named pipe (live frames)
+//
+// gzip/zstd-compressed inputs are decompressed while reading (byte_source.h);
+// `time_encoding=delta` wraps text readers in a DeltaTimeEdgeReader.
+// ---------------------------------------------------------------------------
+class EdgeReaderFactory {
+public:
+    static bool is_supported(const std::string &format) {
+        return format == "text" || format == "mmap" || format == "binary" || is_live(format);
+    }
+
+    // Formats served by a long-running producer rather than read from a file.
+    static bool is_live(const std::string &format) {
+        return format == "socket" || format == "fifo";
+    }
+
+    static bool is_supported_time_encoding(const std::string &format, const std::string &time_encoding) {
+        // binary streams always store time deltas, live frames absolute timestamps
+        return time_encoding == "absolute" || (time_encoding == "delta" && format != "binary" && !is_live(format));
+    }
+
+    static std::unique_ptr<EdgeReader> create(const std::string &format, const std::string &path,
+                                              const std::string &time_encoding = "absolute") {
+        std::unique_ptr<EdgeReader> reader = create_parser(format, path);
+        if (time_encoding == "delta") reader = std::make_unique<DeltaTimeEdgeReader>(std::move(reader));
+        return reader;
+    }
+
+private:
+    EdgeReaderFactory() = delete;
+
+    static std::unique_ptr<EdgeReader> create_parser(const std::string &format, const std::string &path) {
+        if (format == "text") return std::make_unique<TextEdgeReader>(open_byte_source(path));
+        if (format == "mmap") {
+            if (detect_compression(path) == Compression::none) return std::make_unique<MmapTextEdgeReader>(path);
+            std::cerr << "Warning: " << path << " is compressed, reading it as input_format=text" << std::endl;
+            return std::make_unique<TextEdgeReader>(open_byte_source(path));
+        }
+        if (format == "binary") return std::make_unique<BinaryEdgeReader>(open_byte_source(path), path);
+        if (format == "socket") return std::make_unique<StreamServerReader>(StreamServerReader::Endpoint::socket, path);
+        if (format == "fifo") return std::make_unique<StreamServerReader>(StreamServerReader::Endpoint::fifo, path);
+        throw std::invalid_argument("EdgeReaderFactory: unknown input format " + format);
+    }
+};
+
+#endif //ADA_EDGE_READER_FACTORY_H
@@ -0,0 +1,155 @@
+#ifndef ADA_EDGE_SOURCE_H
+#define ADA_EDGE_SOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "edge_reader.h"
+#include "spsc_ring.h"
+#include "../fsa.h"
+
+// An edge ready for ModeHandler::process_edge: the timestamp is rebased on
+// the first edge of the stream and the label is known to be in the query.
+struct ingest_edge {
+    long long s;
+    long long d;
+    long long l;
+    long long time;
+    std::uint64_t offset; // input records read up to and including this one
+};
+
+// ---------------------------------------------------------------------------
+// EdgePrefilter  —  t0 rebasing and label filtering, formerly inline in the
+// main loop
+// ---------------------------------------------------------------------------
+class EdgePrefilter {
+    const FiniteStateAutomaton &aut_;
+    long long t0_ = 0;
+    std::uint64_t records_ = 0;
+
+public:
+    explicit EdgePrefilter(const FiniteStateAutomaton &aut) : aut_(aut) {}
+
+    // Continue a checkpointed stream whose first `records` records were consumed.
+    void resume(const long long t0, const std::uint64_t records) {
+        t0_ = t0;
+        records_ = records;
+    }
+
+    [[nodiscard]] long long origin() const {
+        return t0_;
+    }
+
+    // False if the edge must be skipped.
+    bool admit(const stream_edge &e, ingest_edge &out) {
+        records_++;
+        if (t0_ == 0) t0_ = e.t;
+        long long time = e.t - t0_;
+        if (time < 0) return false;
+        if (time == 0) time = 1;
+
+        // process the edge only if the label is part of the query
+        if (!aut_.hasLabel(e.l)) return false;
+
+        out = {e.s, e.d, e.l, time, records_};
+        return true;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// EdgeSource  —  batches of prefiltered edges for the processing loop
+// ---------------------------------------------------------------------------
+class EdgeSource {
+public:
+    static constexpr std::size_t batch_size = 256;
+
+    virtual ~EdgeSource() = default;
+
+    // Fills out with up to max edges; returns 0 only at end of stream.
+    virtual std::size_t next_batch(ingest_edge *out, std::size_t max) = 0;
+
+    // Time origin of the stream, valid once an edge has been returned.
+    [[nodiscard]] virtual long long origin() const = 0;
+};
+
+// Reads and filters on the calling thread. A partial batch is returned rather
+// than waiting on a live producer, so acknowledged edges are processed first.
+class SerialEdgeSource final : public EdgeSource {
+    std::unique_ptr<EdgeReader> reader_;
+    EdgePrefilter prefilter_;
+
+public:
+    SerialEdgeSource(std::unique_ptr<EdgeReader> reader, const EdgePrefilter &prefilter)
+        : reader_(std::move(reader)), prefilter_(prefilter) {}
+
+    std::size_t next_batch(ingest_edge *out, const std::size_t max) override {
+        std::size_t n = 0;
+        stream_edge e{};
+        while (n < max && (n == 0 || reader_->ready()) && reader_->next(e)) {
+            if (prefilter_.admit(e, out[n])) n++;
+        }
+        return n;
+    }
+
+    [[nodiscard]] long long origin() const override {
+        return prefilter_.origin();
+    }
+};
+
+// Reads and filters on a dedicated thread that feeds a bounded SPSC ring; the
+// processing thread drains the ring in batches. Both sides yield while the
+// ring is full or empty.
+class PipelinedEdgeSource final : public EdgeSource {
+    std::unique_ptr<EdgeReader> reader_;
+    EdgePrefilter prefilter_;
+    SpscRing<ingest_edge> ring_;
+    std::atomic<bool> done_{false};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+
+    void produce() {
+        stream_edge e{};
+        ingest_edge edge{};
+        while (!stop_.load(std::memory_order_relaxed) && reader_->next(e)) {
+            if (!prefilter_.admit(e, edge)) continue;
+            while (!ring_.try_push(edge)) {
+                if (stop_.load(std::memory_order_relaxed)) return;
+                std::this_thread::yield();
+            }
+        }
+        done_.store(true, std::memory_order_release);
+    }
+
+public:
+    PipelinedEdgeSource(std::unique_ptr<EdgeReader> reader, const EdgePrefilter &prefilter, const std::size_t capacity)
+        : reader_(std::move(reader)), prefilter_(prefilter), ring_(capacity) {
+        thread_ = std::thread(&PipelinedEdgeSource::produce, this);
+    }
+
+    ~PipelinedEdgeSource() override {
+        stop_.store(true, std::memory_order_relaxed);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    PipelinedEdgeSource(const PipelinedEdgeSource &) = delete;
+    PipelinedEdgeSource &operator=(const PipelinedEdgeSource &) = delete;
+
+    std::size_t next_batch(ingest_edge *out, const std::size_t max) override {
+        while (true) {
+            if (const std::size_t n = ring_.pop_batch(out, max)) return n;
+            // done_ is set after the last push, so one more pop sees every edge
+            if (done_.load(std::memory_order_acquire)) return ring_.pop_batch(out, max);
+            std::this_thread::yield();
+        }
+    }
+
+    // t0 is written once, before the first push; popping an edge orders this read after it
+    [[nodiscard]] long long origin() const override {
+        return prefilter_.origin();
+    }
+};
+
+#endif //ADA_EDGE_SOURCE_H
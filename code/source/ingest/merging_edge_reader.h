@@ -0,0 +1,69 @@
+#ifndef ADA_MERGING_EDGE_READER_H
+#define ADA_MERGING_EDGE_READER_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "edge_reader.h"
+
+// ---------------------------------------------------------------------------
+// MergingEdgeReader  —  k-way merge of time-ordered shards into one stream
+//
+// Each shard (e.g. one file per label or per producer) must be non-decreasing
+// in t on its own. A min-heap keyed on (t, shard index) holds the next edge of
+// every shard, so the output is non-decreasing in t and edges with the same
+// timestamp come out in shard order, then file order. Each shard keeps its
+// own buffered reader; no shard is read further than its head edge.
+// ---------------------------------------------------------------------------
+class MergingEdgeReader final : public EdgeReader {
+    struct head {
+        long long t;
+        std::size_t shard;
+    };
+
+    // std heap functions build a max-heap; invert to pop the earliest head
+    static bool later(const head &a, const head &b) {
+        return a.t != b.t ? a.t > b.t : a.shard > b.shard;
+    }
+
+    std::vector<std::unique_ptr<EdgeReader>> shards_;
+    std::vector<stream_edge> pending_; // head edge of each shard
+    std::vector<head> heap_;
+    bool primed_ = false;
+
+    void prime() {
+        primed_ = true;
+        pending_.resize(shards_.size());
+        heap_.reserve(shards_.size());
+        for (std::size_t i = 0; i < shards_.size(); i++) {
+            if (shards_[i]->next(pending_[i])) heap_.push_back({pending_[i].t, i});
+        }
+        std::make_heap(heap_.begin(), heap_.end(), later);
+    }
+
+public:
+    explicit MergingEdgeReader(std::vector<std::unique_ptr<EdgeReader>> shards) : shards_(std::move(shards)) {}
+
+    [[nodiscard]] bool is_open() const override {
+        return std::all_of(shards_.begin(), shards_.end(), [](const auto &r) { return r->is_open(); });
+    }
+
+    bool next(stream_edge &e) override {
+        if (!primed_) prime();
+        if (heap_.empty()) return false;
+
+        std::pop_heap(heap_.begin(), heap_.end(), later);
+        const std::size_t shard = heap_.back().shard;
+        e = pending_[shard];
+        if (shards_[shard]->next(pending_[shard])) {
+            heap_.back().t = pending_[shard].t;
+            std::push_heap(heap_.begin(), heap_.end(), later);
+        } else {
+            heap_.pop_back();
+        }
+        return true;
+    }
+};
+
+#endif //ADA_MERGING_EDGE_READER_H
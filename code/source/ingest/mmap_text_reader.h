@@ -0,0 +1,79 @@
+#ifndef ADA_MMAP_TEXT_READER_H
+#define ADA_MMAP_TEXT_READER_H
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "edge_reader.h"
+#include "text_scan.h"
+
+// ---------------------------------------------------------------------------
+// MmapTextEdgeReader  —  "s d l t" text streams read through mmap
+//
+// Produces the same tuples as TextEdgeReader on an uncompressed file, without
+// copying the input through a read buffer.
+// ---------------------------------------------------------------------------
+class MmapTextEdgeReader final : public EdgeReader {
+    int fd_ = -1;
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    const char *cur_ = nullptr;
+    const char *end_ = nullptr;
+
+public:
+    explicit MmapTextEdgeReader(const std::string &path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) return;
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+            return;
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void *mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd_);
+                fd_ = -1;
+                return;
+            }
+            ::madvise(mapped, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(mapped);
+        }
+        cur_ = data_;
+        end_ = data_ + size_;
+    }
+
+    ~MmapTextEdgeReader() override {
+        if (data_) ::munmap(const_cast<char *>(data_), size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    MmapTextEdgeReader(const MmapTextEdgeReader &) = delete;
+    MmapTextEdgeReader &operator=(const MmapTextEdgeReader &) = delete;
+
+    [[nodiscard]] bool is_open() const override {
+        return fd_ >= 0;
+    }
+
+    bool next(stream_edge &e) override {
+        long long *fields[4] = {&e.s, &e.d, &e.l, &e.t};
+        for (long long *field : fields) {
+            const char *start = text_scan::skip_space(cur_, end_);
+            const char *stop = text_scan::parse_integer(start, text_scan::find_space(start, end_), *field);
+            if (!stop) {
+                cur_ = end_;
+                return false;
+            }
+            cur_ = stop;
+        }
+        return true;
+    }
+};
+
+#endif //ADA_MMAP_TEXT_READER_H
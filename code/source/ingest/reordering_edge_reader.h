@@ -0,0 +1,105 @@
+#ifndef ADA_REORDERING_EDGE_READER_H
+#define ADA_REORDERING_EDGE_READER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "edge_reader.h"
+
+// ---------------------------------------------------------------------------
+// ReorderingEdgeReader  —  `max_lateness`: bounded reorder buffer for streams
+// with slight disorder, e.g. concurrent producers
+//
+// Edges are held in a min-heap keyed on (t, arrival). The watermark trails the
+// largest timestamp seen by max_lateness; buffered edges at or below it are
+// released in timestamp order, ties in arrival order. Windows and slides are
+// therefore only closed by edges the watermark has passed. An edge that
+// arrives behind the last released timestamp is late: it is counted, written
+// to the side output (if any) and dropped. When the buffer holds more than
+// capacity edges the earliest one is released regardless of the watermark.
+// ---------------------------------------------------------------------------
+class ReorderingEdgeReader final : public EdgeReader {
+    struct held {
+        stream_edge e;
+        std::uint64_t arrival;
+    };
+
+    // std heap functions build a max-heap; invert to pop the earliest edge
+    static bool later(const held &a, const held &b) {
+        return a.e.t != b.e.t ? a.e.t > b.e.t : a.arrival > b.arrival;
+    }
+
+    std::unique_ptr<EdgeReader> inner_;
+    long long max_lateness_;
+    std::size_t capacity_;
+    std::vector<held> heap_;
+    std::uint64_t arrivals_ = 0;
+    long long max_seen_ = std::numeric_limits<long long>::min();
+    long long released_ = std::numeric_limits<long long>::min(); // timestamp of the last released edge
+    bool exhausted_ = false;
+
+    std::uint64_t late_count_ = 0;
+    std::ostream *late_out_ = nullptr;
+
+    [[nodiscard]] bool releasable() const {
+        return !heap_.empty() && (exhausted_ || heap_.size() > capacity_ || heap_.front().e.t <= watermark());
+    }
+
+public:
+    ReorderingEdgeReader(std::unique_ptr<EdgeReader> inner, const long long max_lateness, const std::size_t capacity)
+        : inner_(std::move(inner)), max_lateness_(max_lateness), capacity_(capacity) {}
+
+    // Late edges are written as "s,d,l,t,lateness" rows, lateness being how
+    // far t is behind the last released timestamp.
+    void set_late_output(std::ostream *out) {
+        late_out_ = out;
+    }
+
+    [[nodiscard]] std::uint64_t late_count() const {
+        return late_count_;
+    }
+
+    [[nodiscard]] long long watermark() const {
+        return max_seen_ == std::numeric_limits<long long>::min() ? max_seen_ : max_seen_ - max_lateness_;
+    }
+
+    [[nodiscard]] bool is_open() const override {
+        return inner_->is_open();
+    }
+
+    [[nodiscard]] bool ready() const override {
+        return releasable() || (!exhausted_ && inner_->ready());
+    }
+
+    bool next(stream_edge &e) override {
+        while (!releasable()) {
+            if (exhausted_) return false;
+            stream_edge in{};
+            if (!inner_->next(in)) {
+                exhausted_ = true;
+                continue;
+            }
+            if (in.t < released_) {
+                late_count_++;
+                if (late_out_) {
+                    *late_out_ << in.s << "," << in.d << "," << in.l << "," << in.t << "," << released_ - in.t << "\n";
+                }
+                continue;
+            }
+            max_seen_ = std::max(max_seen_, in.t);
+            heap_.push_back({in, arrivals_++});
+            std::push_heap(heap_.begin(), heap_.end(), later);
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), later);
+        e = heap_.back().e;
+        heap_.pop_back();
+        released_ = e.t;
+        return true;
+    }
+};
+
+#endif //ADA_REORDERING_EDGE_READER_H
@@ -0,0 +1,200 @@
+#ifndef ADA_REPLAY_EDGE_READER_H
+#define ADA_REPLAY_EDGE_READER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "edge_reader.h"
+
+// ---------------------------------------------------------------------------
+// RateProfile  —  `replay_profile` / `replay_rate`: piecewise input-rate
+// multipliers over the original stream time
+//
+//   replay_profile=spike:<from>:<to>:<x>,ramp:<from>:<to>:<x0>:<x1>,...
+//
+// Offsets are in timestamp units from the first record. A spike multiplies
+// the input rate by x over [from, to); a ramp changes the multiplier linearly
+// from x0 to x1. Outside the pieces the multiplier is `replay_rate`. A record
+// at offset u is moved to offset integral_0^u du / m(u), so 4x compresses a
+// range to a quarter of its span and keeps the order of the edges.
+// ---------------------------------------------------------------------------
+class RateProfile {
+    struct Piece {
+        double from; // original offset
+        double to;
+        double x0;   // multiplier at from
+        double x1;   // multiplier at to
+        double y0;   // rescaled offset at from
+    };
+
+    std::vector<Piece> pieces_; // sorted, covering [0, inf)
+
+    // Rescaled length of [p.from, u) for u inside p.
+    static double integral(const Piece &p, const double u) {
+        if (p.x0 == p.x1 || std::isinf(p.to)) return (u - p.from) / p.x0;
+        const double x = p.x0 + (p.x1 - p.x0) * (u - p.from) / (p.to - p.from);
+        return (p.to - p.from) / (p.x1 - p.x0) * std::log(x / p.x0);
+    }
+
+public:
+    // False with a message in error if spec is malformed; pieces must be in
+    // increasing order and must not overlap.
+    static bool parse(const std::string &spec, const double base, RateProfile &out, std::string &error) {
+        if (!(base > 0)) {
+            error = "replay_rate should be > 0";
+            return false;
+        }
+        std::vector<Piece> explicit_pieces;
+        std::istringstream pieces(spec);
+        std::string item;
+        while (std::getline(pieces, item, ',')) {
+            if (item.empty()) continue;
+            std::vector<std::string> fields;
+            std::istringstream fs(item);
+            for (std::string f; std::getline(fs, f, ':');) fields.push_back(f);
+
+            Piece p{};
+            try {
+                if (fields[0] == "spike" && fields.size() == 4) {
+                    p = {std::stod(fields[1]), std::stod(fields[2]), std::stod(fields[3]), std::stod(fields[3]), 0};
+                } else if (fields[0] == "ramp" && fields.size() == 5) {
+                    p = {std::stod(fields[1]), std::stod(fields[2]), std::stod(fields[3]), std::stod(fields[4]), 0};
+                } else {
+                    error = "replay_profile: unknown piece " + item;
+                    return false;
+                }
+            } catch (const std::exception &) {
+                error = "replay_profile: bad number in " + item;
+                return false;
+            }
+            if (!(p.from >= 0 && p.from < p.to)) {
+                error = "replay_profile: empty or negative range in " + item;
+                return false;
+            }
+            if (!(p.x0 > 0 && p.x1 > 0)) {
+                error = "replay_profile: multipliers should be > 0 in " + item;
+                return false;
+            }
+            if (!explicit_pieces.empty() && p.from < explicit_pieces.back().to) {
+                error = "replay_profile: " + item + " overlaps the previous piece";
+                return false;
+            }
+            explicit_pieces.push_back(p);
+        }
+
+        // fill the gaps with the base rate and accumulate the rescaled offsets
+        out.pieces_.clear();
+        double u = 0, y = 0;
+        const auto append = [&](Piece p) {
+            p.y0 = y;
+            y += integral(p, p.to);
+            u = p.to;
+            out.pieces_.push_back(p);
+        };
+        for (const Piece &p : explicit_pieces) {
+            if (p.from > u) append({u, p.from, base, base, 0});
+            append(p);
+        }
+        append({u, std::numeric_limits<double>::infinity(), base, base, 0});
+        return true;
+    }
+
+    // Rescaled offset of original offset u >= 0.
+    [[nodiscard]] double rescale(const double u) const {
+        const auto it = std::upper_bound(pieces_.begin(), pieces_.end(), u,
+                                         [](const double v, const Piece &p) { return v < p.to; });
+        return it->y0 + integral(*it, u);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// ReplayEdgeReader  —  replays a recorded stream through a RateProfile and,
+// with `replay_speed` > 0, paces delivery to that many rescaled timestamp
+// units per wall-clock second
+//
+// Pacing sleeps in next(); ready() turns false while the next edge is not due
+// yet, so a batching source hands over what it has instead of waiting.
+// ---------------------------------------------------------------------------
+class ReplayEdgeReader final : public EdgeReader {
+    using steady = std::chrono::steady_clock;
+
+    std::unique_ptr<EdgeReader> inner_;
+    RateProfile profile_;
+    double speed_;
+
+    bool started_ = false;
+    long long origin_ = 0;     // first original timestamp
+    bool paced_ = false;       // pacing clock running
+    steady::time_point wall0_;
+    double y0_ = 0;            // rescaled offset at wall0_
+    bool has_pending_ = false; // prefetched edge
+    stream_edge pending_{};
+    double pending_y_ = 0;
+
+    bool fetch() {
+        if (!inner_->next(pending_)) return false;
+        if (!started_) {
+            started_ = true;
+            origin_ = pending_.t;
+        }
+        // records before the first one keep their (negative) offset
+        const double u = static_cast<double>(pending_.t - origin_);
+        pending_y_ = u >= 0 ? profile_.rescale(u) : u;
+        pending_.t = origin_ + std::llround(pending_y_);
+        has_pending_ = true;
+        return true;
+    }
+
+    [[nodiscard]] steady::time_point due(const double y) const {
+        return wall0_ + std::chrono::duration_cast<steady::duration>(std::chrono::duration<double>((y - y0_) / speed_));
+    }
+
+public:
+    ReplayEdgeReader(std::unique_ptr<EdgeReader> inner, RateProfile profile, const double speed)
+        : inner_(std::move(inner)), profile_(std::move(profile)), speed_(speed) {}
+
+    [[nodiscard]] bool is_open() const override {
+        return inner_->is_open();
+    }
+
+    [[nodiscard]] bool ready() const override {
+        if (speed_ <= 0) return inner_->ready();
+        return has_pending_ && (!paced_ || due(pending_y_) <= steady::now());
+    }
+
+    bool next(stream_edge &e) override {
+        if (!has_pending_ && !fetch()) return false;
+        if (speed_ > 0) {
+            if (!paced_) {
+                paced_ = true;
+                wall0_ = steady::now();
+                y0_ = pending_y_;
+            }
+            std::this_thread::sleep_until(due(pending_y_));
+        }
+        e = pending_;
+        has_pending_ = false;
+        if (speed_ > 0 && inner_->ready()) fetch();
+        return true;
+    }
+
+    // Rescales the skipped records without pacing them.
+    std::uint64_t skip(const std::uint64_t n) override {
+        std::uint64_t skipped = 0;
+        for (; skipped < n; skipped++) {
+            if (!has_pending_ && !fetch()) break;
+            has_pending_ = false;
+        }
+        return skipped;
+    }
+};
+
+#endif //ADA_REPLAY_EDGE_READER_H
@@ -0,0 +1,74 @@
+#ifndef ADA_SPSC_RING_H
+#define ADA_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// SpscRing  —  bounded lock-free ring for exactly one producer thread and one
+// consumer thread
+//
+// Capacity is rounded up to a power of two. head_ is written only by the
+// consumer and tail_ only by the producer; each side caches the other's index
+// and reloads it only when the ring looks full (producer) or empty (consumer).
+// ---------------------------------------------------------------------------
+template<typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing stores POD records");
+    static constexpr std::size_t cache_line = 64;
+
+    std::vector<T> slots_;
+    std::size_t mask_;
+
+    alignas(cache_line) std::atomic<std::size_t> head_{0}; // next slot to pop
+    std::size_t cached_tail_ = 0;                          // consumer's view of tail_
+
+    alignas(cache_line) std::atomic<std::size_t> tail_{0}; // next slot to push
+    std::size_t cached_head_ = 0;                          // producer's view of head_
+
+    static std::size_t round_up(std::size_t n) {
+        std::size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+public:
+    explicit SpscRing(const std::size_t capacity) : slots_(round_up(capacity)), mask_(slots_.size() - 1) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    [[nodiscard]] std::size_t capacity() const {
+        return slots_.size();
+    }
+
+    // Producer side: returns false if the ring is full.
+    bool try_push(const T &item) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) return false;
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: moves up to max items into out and returns how many.
+    std::size_t pop_batch(T *out, const std::size_t max) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ == head) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (cached_tail_ == head) return 0;
+        }
+        std::size_t n = cached_tail_ - head;
+        if (n > max) n = max;
+        for (std::size_t i = 0; i < n; i++) out[i] = slots_[(head + i) & mask_];
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+};
+
+#endif //ADA_SPSC_RING_H
@@ -0,0 +1,262 @@
+#ifndef ADA_STREAM_SERVER_READER_H
+#define ADA_STREAM_SERVER_READER_H
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "binary_edge_reader.h"
+#include "edge_reader.h"
+
+// Live edge frames (all fields little-endian).
+//
+//   offset  size    field
+//   0       4       count: uint32, number of records in the frame
+//   4       32 * n  records: int64 s, int64 d, int64 l, int64 t
+//
+// count == shutdown_count ends the stream: the server finishes the run and
+// writes its results. On a Unix socket every frame, including an empty one, is
+// acknowledged with its uint32 count once all of its records have been taken
+// by the engine (processed with the serial source, queued with
+// pipelined_ingest), so a producer that waits for the ack of a frame before
+// sending the next one is throttled to the processing rate. A FIFO carries no
+// acks; the pipe buffer is the only backpressure there, and concurrent
+// writers must not send frames larger than PIPE_BUF.
+namespace stream_frame_format {
+    constexpr std::uint32_t shutdown_count = 0xFFFFFFFF;
+    constexpr std::uint32_t max_count = 1 << 20;
+    constexpr std::size_t header_size = 4;
+    constexpr std::size_t record_size = 4 * 8;
+}
+
+// Set by SIGINT/SIGTERM while a StreamServerReader is open.
+inline volatile std::sig_atomic_t stream_server_stop = 0;
+
+// ---------------------------------------------------------------------------
+// StreamServerReader  —  `input_format=socket|fifo`: edge frames from
+// producers on a Unix domain socket or a named pipe at input_data_path
+//
+// Producers may come and go: the socket accepts one connection after another
+// and the FIFO is held open for writing by the reader itself, so it never sees
+// end of file. The stream ends on a shutdown frame, SIGINT or SIGTERM; blocking
+// waits are polled so a signal is noticed within poll_ms.
+// ---------------------------------------------------------------------------
+class StreamServerReader final : public EdgeReader {
+public:
+    enum class Endpoint { socket, fifo };
+
+private:
+    static constexpr int poll_ms = 250;
+
+    Endpoint endpoint_;
+    std::string path_;
+    int listen_fd_ = -1;
+    int fd_ = -1;         // connection or FIFO read end
+    int fifo_keep_ = -1;  // FIFO write end held by the reader
+    bool open_ = false;
+    bool done_ = false;
+
+    std::vector<unsigned char> frame_;
+    std::uint32_t count_ = 0;
+    std::uint32_t next_ = 0; // next record in frame_
+    bool ack_due_ = false;
+
+    static void on_signal(int) {
+        stream_server_stop = 1;
+    }
+
+    static void install_signal_handlers() {
+        struct sigaction sa{};
+        sa.sa_handler = on_signal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = 0;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+    }
+
+    bool open_socket() {
+        sockaddr_un addr{};
+        if (path_.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Error: socket path too long: " << path_ << std::endl;
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) return false;
+        // a socket file left behind by a previous run
+        if (struct stat st{}; ::stat(path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) ::unlink(path_.c_str());
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd_, 1) < 0) {
+            std::cerr << "Error: cannot listen on " << path_ << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool open_fifo() {
+        if (::mkfifo(path_.c_str(), 0600) < 0 && errno != EEXIST) {
+            std::cerr << "Error: cannot create FIFO " << path_ << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (struct stat st{}; ::stat(path_.c_str(), &st) < 0 || !S_ISFIFO(st.st_mode)) {
+            std::cerr << "Error: " << path_ << " is not a FIFO" << std::endl;
+            return false;
+        }
+        fd_ = ::open(path_.c_str(), O_RDONLY | O_NONBLOCK);
+        if (fd_ < 0) return false;
+        fifo_keep_ = ::open(path_.c_str(), O_WRONLY | O_NONBLOCK);
+        return fifo_keep_ >= 0;
+    }
+
+    // Waits until fd is readable; false on a stop signal.
+    static bool wait_readable(const int fd) {
+        pollfd p{fd, POLLIN, 0};
+        while (!stream_server_stop) {
+            const int ready = ::poll(&p, 1, poll_ms);
+            if (ready > 0) return true;
+            if (ready < 0 && errno != EINTR) return false;
+        }
+        return false;
+    }
+
+    bool accept_connection() {
+        while (fd_ < 0) {
+            if (!wait_readable(listen_fd_)) return false;
+            fd_ = ::accept(listen_fd_, nullptr, nullptr);
+        }
+        return true;
+    }
+
+    void drop_connection() {
+        if (endpoint_ == Endpoint::socket && fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        ack_due_ = false;
+    }
+
+    enum class Read { ok, closed, stopped };
+
+    // Reads exactly n bytes; `closed` if the producer went away first.
+    Read read_exact(unsigned char *buf, std::size_t n) {
+        while (n > 0) {
+            if (!wait_readable(fd_)) return Read::stopped;
+            const ssize_t got = ::read(fd_, buf, n);
+            if (got > 0) {
+                buf += got;
+                n -= static_cast<std::size_t>(got);
+            } else if (got == 0) {
+                return Read::closed;
+            } else if (errno != EAGAIN && errno != EINTR) {
+                return Read::closed;
+            }
+        }
+        return Read::ok;
+    }
+
+    void send_ack() {
+        ack_due_ = false;
+        if (endpoint_ != Endpoint::socket) return;
+        unsigned char ack[4];
+        for (int i = 0; i < 4; i++) ack[i] = static_cast<unsigned char>(count_ >> (8 * i));
+        if (::send(fd_, ack, sizeof(ack), MSG_NOSIGNAL) != sizeof(ack)) drop_connection();
+    }
+
+    // Loads the next non-empty frame; false once the stream has ended.
+    bool read_frame() {
+        using namespace stream_frame_format;
+        while (!done_) {
+            if (ack_due_) send_ack();
+            if (endpoint_ == Endpoint::socket && !accept_connection()) break;
+
+            unsigned char header[header_size];
+            Read r = read_exact(header, header_size);
+            if (r == Read::stopped) break;
+            if (r == Read::closed) {
+                drop_connection();
+                continue;
+            }
+            const auto count = binary_edge_format::load_le<std::uint32_t>(header);
+            if (count == shutdown_count) break;
+            if (count > max_count) {
+                std::cerr << "Error: edge frame of " << count << " records exceeds " << max_count << std::endl;
+                // a FIFO cannot be resynchronised
+                if (endpoint_ == Endpoint::fifo) break;
+                drop_connection();
+                continue;
+            }
+
+            frame_.resize(count * record_size);
+            r = read_exact(frame_.data(), frame_.size());
+            if (r == Read::stopped) break;
+            if (r == Read::closed) {
+                std::cerr << "Warning: producer left in the middle of a frame, " << count
+                        << " edges dropped" << std::endl;
+                drop_connection();
+                continue;
+            }
+            count_ = count;
+            next_ = 0;
+            ack_due_ = true;
+            if (count > 0) return true;
+        }
+        done_ = true;
+        return false;
+    }
+
+public:
+    StreamServerReader(const Endpoint endpoint, std::string path) : endpoint_(endpoint), path_(std::move(path)) {
+        open_ = endpoint_ == Endpoint::socket ? open_socket() : open_fifo();
+        if (open_) {
+            install_signal_handlers();
+            std::cout << "Waiting for edge frames on " << (endpoint_ == Endpoint::socket ? "socket " : "FIFO ")
+                    << path_ << std::endl;
+        }
+    }
+
+    ~StreamServerReader() override {
+        if (fd_ >= 0) ::close(fd_);
+        if (fifo_keep_ >= 0) ::close(fifo_keep_);
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            ::unlink(path_.c_str());
+        }
+    }
+
+    StreamServerReader(const StreamServerReader &) = delete;
+    StreamServerReader &operator=(const StreamServerReader &) = delete;
+
+    [[nodiscard]] bool is_open() const override {
+        return open_;
+    }
+
+    // Blocking only happens between frames.
+    [[nodiscard]] bool ready() const override {
+        return next_ < count_;
+    }
+
+    bool next(stream_edge &e) override {
+        if (next_ == count_ && !read_frame()) return false;
+        const unsigned char *p = frame_.data() + next_ * stream_frame_format::record_size;
+        e.s = binary_edge_format::load_le<std::int64_t>(p);
+        e.d = binary_edge_format::load_le<std::int64_t>(p + 8);
+        e.l = binary_edge_format::load_le<std::int64_t>(p + 16);
+        e.t = binary_edge_format::load_le<std::int64_t>(p + 24);
+        next_++;
+        return true;
+    }
+};
+
+#endif //ADA_STREAM_SERVER_READER_H
@@ -0,0 +1,72 @@
+#ifndef ADA_TEXT_EDGE_READER_H
+#define ADA_TEXT_EDGE_READER_H
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "byte_source.h"
+#include "edge_reader.h"
+#include "text_scan.h"
+
+// ---------------------------------------------------------------------------
+// TextEdgeReader  —  whitespace-separated "s d l t" records (legacy format)
+//
+// Parses a ByteSource through a fixed 64 KiB buffer, so plain and compressed
+// files are read the same way. Token semantics match ifstream extraction:
+// each field is the longest integer prefix of its token, and the stream ends
+// at the first field where there is none.
+// ---------------------------------------------------------------------------
+class TextEdgeReader final : public EdgeReader {
+    static constexpr std::size_t buffer_size = 1 << 16;
+
+    std::unique_ptr<ByteSource> source_;
+    std::vector<char> buffer_;
+    const char *cur_;
+    const char *end_;
+    bool eof_ = false;
+
+    // Moves the unread bytes to the front of the buffer and appends more input.
+    void refill() {
+        const std::size_t rest = end_ - cur_;
+        std::memmove(buffer_.data(), cur_, rest);
+        const std::size_t got = source_->read(buffer_.data() + rest, buffer_.size() - rest);
+        if (got == 0) eof_ = true;
+        cur_ = buffer_.data();
+        end_ = cur_ + rest + got;
+    }
+
+    bool next_field(long long &out) {
+        while ((cur_ = text_scan::skip_space(cur_, end_)) == end_) {
+            if (eof_) return false;
+            refill();
+        }
+        // a token must not end at the buffer boundary unless the input does
+        const char *stop;
+        while ((stop = text_scan::find_space(cur_, end_)) == end_ && !eof_
+               && !(cur_ == buffer_.data() && end_ == buffer_.data() + buffer_.size())) {
+            refill();
+        }
+        stop = text_scan::parse_integer(cur_, stop, out);
+        if (!stop) return false;
+        cur_ = stop;
+        return true;
+    }
+
+public:
+    explicit TextEdgeReader(std::unique_ptr<ByteSource> source)
+        : source_(std::move(source)), buffer_(buffer_size), cur_(buffer_.data()), end_(buffer_.data()) {}
+
+    [[nodiscard]] bool is_open() const override {
+        return source_->is_open();
+    }
+
+    bool next(stream_edge &e) override {
+        if (next_field(e.s) && next_field(e.d) && next_field(e.l) && next_field(e.t)) return true;
+        cur_ = end_;
+        eof_ = true;
+        return false;
+    }
+};
+
+#endif //ADA_TEXT_EDGE_READER_H
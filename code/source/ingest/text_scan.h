@@ -0,0 +1,96 @@
+#ifndef ADA_TEXT_SCAN_H
+#define ADA_TEXT_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Token scanning and integer parsing over an in-memory "s d l t" text buffer.
+// Tokens are separated by any byte <= ' ' (space, tab, CR, LF, ...), which is
+// the whitespace set skipped by ifstream extraction.
+namespace text_scan {
+    inline bool is_space(const unsigned char c) {
+        return c <= ' ';
+    }
+
+    // First position in [p, end) that is not whitespace.
+    inline const char *skip_space(const char *p, const char *end) {
+#if defined(__SSE2__)
+        const __m128i threshold = _mm_set1_epi8(' ' + 1);
+        while (end - p >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            // unsigned byte >= '!' <=> max(byte, '!') == byte
+            const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, threshold), chunk));
+            if (mask) return p + __builtin_ctz(mask);
+            p += 16;
+        }
+#endif
+        while (p < end && is_space(static_cast<unsigned char>(*p))) ++p;
+        return p;
+    }
+
+    // First whitespace position in [p, end), or end.
+    inline const char *find_space(const char *p, const char *end) {
+#if defined(__SSE2__)
+        const __m128i threshold = _mm_set1_epi8(' ' + 1);
+        while (end - p >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            const int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, threshold), chunk)) & 0xFFFF;
+            if (mask) return p + __builtin_ctz(mask);
+            p += 16;
+        }
+#endif
+        while (p < end && !is_space(static_cast<unsigned char>(*p))) ++p;
+        return p;
+    }
+
+    // Converts 8 ASCII digits at p into their value with SWAR arithmetic;
+    // returns false if any of the 8 bytes is not a digit.
+    inline bool parse_eight_digits(const char *p, std::uint64_t &out) {
+        std::uint64_t v;
+        std::memcpy(&v, p, 8);
+        if ((((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+             != 0x3333333333333333ULL))
+            return false;
+        v = (v & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+        v = (v & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+        out = (v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+        return true;
+    }
+
+    // Parses the longest signed decimal prefix of [p, end) into out and returns
+    // the position after it, or nullptr if there is no such prefix or it is
+    // outside the long long range (the cases where ifstream extraction fails).
+    inline const char *parse_integer(const char *p, const char *end, long long &out) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            ++p;
+        }
+        const char *first = p;
+        while (p < end && *p == '0') ++p; // leading zeros do not count towards the 19 digits
+        const char *digits = p;
+        std::uint64_t value = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        for (std::uint64_t chunk; end - p >= 8 && p - digits < 16 && parse_eight_digits(p, chunk); p += 8)
+            value = value * 100000000ULL + chunk;
+#endif
+        for (; p < end && p - digits < 20; ++p) {
+            const unsigned digit = static_cast<unsigned char>(*p) - '0';
+            if (digit > 9) break;
+            value = value * 10 + digit;
+        }
+        // 19 digits always fit in 64 unsigned bits; a 20th is an overflow.
+        if (p == first || p - digits > 19) return nullptr;
+        constexpr std::uint64_t max_positive = 0x7FFFFFFFFFFFFFFFULL;
+        if (value > max_positive + (negative ? 1 : 0)) return nullptr;
+        out = negative ? static_cast<long long>(0 - value) : static_cast<long long>(value);
+        return p;
+    }
+}
+
+#endif //ADA_TEXT_SCAN_H
@@ -0,0 +1,75 @@
+#ifndef ADA_MEMORY_USAGE_H
+#define ADA_MEMORY_USAGE_H
+
+#include <cstddef>
+#include <fstream>
+#include <ostream>
+#include <vector>
+
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// Memory accounting  —  `memory_profiler`: live bytes per engine structure,
+// sampled when a slide closes and written to the slides CSV
+//
+// Every structure estimates its own footprint from container sizes and
+// capacities: a vector is charged its capacity, a hashed container its bucket
+// array plus one heap node per element, an ordered container one node (three
+// links and the colour) per element. Allocator headers and padding are left
+// out, so the sum of the columns stays below the RSS that is sampled with it.
+// ---------------------------------------------------------------------------
+namespace memory_estimate {
+    constexpr std::size_t ptr_size = sizeof(void *);
+
+    template<typename T>
+    std::size_t vector(const std::vector<T> &v) {
+        return v.capacity() * sizeof(T);
+    }
+
+    // unordered_map / unordered_set
+    template<typename C>
+    std::size_t hashed(const C &c) {
+        return c.bucket_count() * ptr_size + c.size() * (ptr_size + sizeof(typename C::value_type));
+    }
+
+    // map / set
+    template<typename C>
+    std::size_t ordered(const C &c) {
+        return c.size() * (4 * ptr_size + sizeof(typename C::value_type));
+    }
+}
+
+struct memory_usage {
+    std::size_t out_adjacency = 0;
+    std::size_t in_adjacency = 0;
+    std::size_t edge_index = 0;  // (from, to, label) index and edge ID index
+    std::size_t vertices = 0;    // vertex table and label counts
+    std::size_t time_list = 0;   // edge panes, holding the sg_edge objects
+    std::size_t tree_nodes = 0;
+    std::size_t node_maps = 0;   // forest map, trees, node maps and TI maps
+    std::size_t v2t_index = 0;
+    std::size_t v2l_index = 0;
+    std::size_t landmarks = 0;   // landmark sets, global and per tree
+    std::size_t sink = 0;
+    std::size_t rss = 0;         // resident set size of the process
+
+    static constexpr const char *csv_columns =
+        "mem_out_adjacency,mem_in_adjacency,mem_edge_index,mem_vertices,mem_time_list,mem_tree_nodes,"
+        "mem_node_maps,mem_v2t_index,mem_v2l_index,mem_landmarks,mem_sink,rss";
+
+    void write_csv(std::ostream &out) const {
+        out << out_adjacency << "," << in_adjacency << "," << edge_index << "," << vertices << "," << time_list << ","
+            << tree_nodes << "," << node_maps << "," << v2t_index << "," << v2l_index << "," << landmarks << ","
+            << sink << "," << rss;
+    }
+};
+
+// Resident set size in bytes, 0 where /proc is not available.
+inline std::size_t process_rss() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+#endif //ADA_MEMORY_USAGE_H
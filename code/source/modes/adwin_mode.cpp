@@ -18,13 +18,10 @@ bool AdwinMode::process_edge(long long s, long long d, long long l, long long ti
     // Set output parameter
     *new_sgt_out = new_sgt;
 
-    // do W ← W ∪ {xt} (i.e., add xt to the head of W )
-    auto* t_edge = new timed_edge(new_sgt);
-    ctx.sg->add_timed_edge(t_edge);
-    new_sgt->time_pos = t_edge;
+    // W ← W ∪ {xt} (i.e., add xt to the head of W ): insert_edge queued it in the time list
 
     // update max degree observed
-    if (ctx.sg->out_degree[new_sgt->s] > ctx.max_deg) ctx.max_deg = ctx.sg->out_degree[new_sgt->s];
+    if (ctx.sg->out_degree(new_sgt->s) > ctx.max_deg) ctx.max_deg = ctx.sg->out_degree(new_sgt->s);
 
     // compute average out degree centrality incrementally
     double avg_deg = ctx.sg->edge_num/ctx.sg->vertex_num;
@@ -46,42 +43,32 @@ bool AdwinMode::process_edge(long long s, long long d, long long l, long long ti
         // std::cout << "    Window length: " << adwin->length() << std::endl;
 
         (ctx.windows)[ctx.resizings].t_close = time;
-        (ctx.windows)[ctx.resizings].latency = static_cast<double>(clock() - (ctx.windows)[ctx.resizings].start_time) / CLOCKS_PER_SEC;
+        (ctx.windows)[ctx.resizings].latency = static_cast<double>(processing_clock() - (ctx.windows)[ctx.resizings].start_time) / CLOCKS_PER_SEC;
         (ctx.windows)[ctx.resizings].total_matched_results = ctx.sink->matched_paths;
         (ctx.windows)[ctx.resizings].emitted_results = ctx.sink->getResultSetSize();
         (ctx.resizings)++;
-        ctx.windows.emplace_back(time, time, nullptr, nullptr, ctx.sink->matched_paths);
-        timed_edge *current = ctx.sg->time_list_head;
+        ctx.windows.emplace_back(time, time, ctx.sink->matched_paths);
         std::vector<std::pair<long long, long long> > candidate_for_deletion;
 
-        while (current && ctx.window_cardinality > adwin->length()) {
-            auto cur_edge = current->edge_pt;
-            auto next = current->next;
+        while (ctx.window_cardinality > adwin->length()) {
+            sg_edge *cur_edge = ctx.sg->time_list.front();
+            if (!cur_edge) break;
 
             candidate_for_deletion.emplace_back(cur_edge->s, cur_edge->d);
 
+            ctx.sg->time_list.pop_front();
             ctx.sg->remove_edge(cur_edge->s, cur_edge->d, cur_edge->label, time);
 
-            ctx.sg->delete_timed_edge(current);
-
             (ctx.window_cardinality)--;
-
-            ctx.sg->time_list_head = next;
-            ctx.sg->time_list_head->prev = nullptr;
-
-            current = next;
         }
 
         ctx.max_deg = 1;
-        while (current) {
-            auto cur_edge = current->edge_pt;
-            auto next = current->next;
-            if (ctx.sg->out_degree[cur_edge->s] > ctx.max_deg) ctx.max_deg = ctx.sg->out_degree[cur_edge->s];
-            current = next;
-        }
+        ctx.sg->time_list.for_each([&](const sg_edge *cur_edge) {
+            if (ctx.sg->out_degree(cur_edge->s) > ctx.max_deg) ctx.max_deg = ctx.sg->out_degree(cur_edge->s);
+        });
 
-        // ctx.sink->refresh_resultSet(ctx.sg->time_list_head->edge_pt->timestamp);
-        //ctx.f->expire_timestamped(ctx.sg->time_list_head->edge_pt->timestamp, candidate_for_deletion);
+        // ctx.sink->refresh_resultSet(ctx.sg->time_list.front()->timestamp);
+        //ctx.f->expire_timestamped(ctx.sg->time_list.front()->timestamp, candidate_for_deletion);
         candidate_for_deletion.clear();
     }
     (ctx.windows)[ctx.resizings].t_close = time;
@@ -101,3 +88,11 @@ bool AdwinMode::process_edge(long long s, long long d, long long l, long long ti
     
     return true;
 }
+
+void AdwinMode::save(CheckpointWriter& w) const {
+    adwin->save(w);
+}
+
+void AdwinMode::load(CheckpointReader& r) {
+    adwin->load(r);
+}
@@ -21,6 +21,10 @@ public:
         ModeContext& ctx,
         sg_edge** new_sgt_out
     ) override;
+
+    void save(CheckpointWriter& w) const override;
+
+    void load(CheckpointReader& r) override;
 };
 
 #endif // ADWIN_MODE_H
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <cassert>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 
@@ -42,11 +43,11 @@ bool LoadSheddingMode::process_edge(long long s, long long d, long long l, long
 
     unsigned int new_sgt_id = new_sgt->id;
 
-    bool evict_condition = update_window(ctx, new_sgt, time, s);
+    bool evict_condition = update_window(ctx, time, s);
 
     if (ctx.mode == 5) {
-        const int src_out = ctx.sg->out_degree.count(s) ? ctx.sg->out_degree.at(s) : 0;
-        const int dst_in = ctx.sg->in_degree.count(d) ? ctx.sg->in_degree.at(d) : 0;
+        const int src_out = ctx.sg->out_degree(s);
+        const int dst_in = ctx.sg->in_degree(d);
         assert(src_out >= 0 && dst_in >= 0);
         // FIXME: This is wrong because is non-local
         const double score = 100 * ((src_out + dst_in) / (src_out + dst_in + (ctx.sg->edge_num/ctx.sg->vertex_num)));
@@ -83,7 +84,7 @@ bool LoadSheddingMode::process_edge(long long s, long long d, long long l, long
                     if (N_t < types_counts[i]) bottom_k_edges = ranks[i].bottom_k(static_cast<size_t>(types_counts[i] - N_t));
                     else bottom_k_edges = ranks[i].bottom_k(static_cast<size_t>(types_counts[i]));
                     for (const auto& edge_id : bottom_k_edges) {
-                        auto& cur_edge = ctx.sg->edge_id_to_edge[edge_id];
+                        sg_edge *cur_edge = ctx.sg->edge_by_id(edge_id);
                         if (cur_edge == nullptr) {
                             std::cerr << "ERROR: Edge with ID " << edge_id << " not found for shedding." << std::endl;
                             continue; // Skip this edge and continue with the next one
@@ -94,8 +95,7 @@ bool LoadSheddingMode::process_edge(long long s, long long d, long long l, long
 
                         deleted_edges.push_back({cur_edge->s, cur_edge->d, cur_edge->label, cur_edge->id});
                         ranks[i].remove(cur_edge->id);
-                        ctx.sg->delete_timed_edge(cur_edge->time_pos); // delete from time list
-                        ctx.sg->remove_edge(cur_edge->s, cur_edge->d, cur_edge->label, time); // delete from adjacency list
+                        ctx.sg->remove_edge(cur_edge->s, cur_edge->d, cur_edge->label, time); // delete from adjacency and time list
                     }
                     //cout << "removed " << deleted_edges.size() << " edges" << endl;
                     ctx.window_cardinality -= deleted_edges.size();
@@ -144,4 +144,23 @@ bool LoadSheddingMode::process_edge(long long s, long long d, long long l, long
     //     << ctx.p_shed << std::endl;
 
     return is_shedding;
-}
\ No newline at end of file
+}
+
+void LoadSheddingMode::save(CheckpointWriter& w) const {
+    std::ostringstream gen_state;
+    gen_state << gen;
+    w.put_string(gen_state.str());
+    w.put_size(ranks.size());
+    for (const auto& rank : ranks) rank.save(w);
+    w.put_vector(types_counts);
+    w.put(N_in);
+}
+
+void LoadSheddingMode::load(CheckpointReader& r) {
+    std::istringstream gen_state(r.get_string());
+    gen_state >> gen;
+    if (r.get_size() != ranks.size()) r.fail("label count differs from the configuration");
+    for (auto& rank : ranks) rank.load(r);
+    r.get_vector(types_counts);
+    r.get(N_in);
+}
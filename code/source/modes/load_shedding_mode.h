@@ -31,6 +31,10 @@ public:
         ModeContext& ctx,
         sg_edge** new_sgt_out
     ) override;
+
+    void save(CheckpointWriter& w) const override;
+
+    void load(CheckpointReader& r) override;
 };
 
 #endif // LOAD_SHEDDING_MODE_H
@@ -6,19 +6,46 @@
 #include <fstream>
 #include <sstream>
 #include <limits>
+#include <ctime>
 
+#include "../memory_usage.h"
 #include "../streaming_graph.h"
 #include "../sink.h"
 #include "../fsa.h"
+#include "../query_compiler.h"
 #include "../query_handler.h"
+#include "../ingest/edge_reader_factory.h"
+#include "../ingest/replay_edge_reader.h"
 
 typedef struct Config {
     std::string input_data_path;
+    std::vector<std::string> input_data_paths; // input_data_path split on ','
+    std::string input_format = "text";
+    std::string time_encoding = "absolute";
+    bool pipelined_ingest = false;
+    std::size_t ingest_queue_capacity = 1 << 16;
+    std::string checkpoint_path;   // empty: no checkpoints
+    int checkpoint_every = 1;      // slides between checkpoints
+    std::string restore_from;      // empty: start from the beginning of the stream
+    bool replay = false;           // any replay_* key set
+    std::string replay_profile;
+    double replay_rate = 1.0;      // input-rate multiplier outside the profile's pieces
+    double replay_speed = 0.0;     // rescaled timestamp units per wall-clock second, 0: unpaced
+    std::string replay_tag;        // appended to the dataset name in output file names
+    RateProfile rate_profile;
+    long long max_lateness = -1;   // reorder buffer lateness bound, -1: no reordering
+    std::size_t reorder_capacity = 1 << 20;
+    adjacency_store adjacency = adjacency_store::map;
+    bool memory_profiler = false;  // per-slide memory accounting in the slides CSV
     int mode{};
     long long size{};
     long long slide{};
     long long query_type{};
     std::vector<long long> labels;
+    std::string query;             // regular expression replacing query_type and labels, empty: built-in query
+    std::unordered_map<std::string, long long> label_map; // label names in query -> label IDs
+    query_automaton compiled_query;
+    std::string query_tag;         // stands for query_type in output file names when query is set
     int max_size{};
     int min_size{};
     double l_max{};
@@ -54,16 +81,140 @@ inline config readConfig(const std::string &filename) {
 
     // Convert values from the map
     config.input_data_path = configMap["input_data_path"];
+    std::istringstream pathsStream(config.input_data_path);
+    std::string path;
+    while (std::getline(pathsStream, path, ',')) {
+        if (!path.empty()) config.input_data_paths.push_back(path);
+    }
+    if (config.input_data_paths.empty()) {
+        std::cerr << "Error: input_data_path should be set" << std::endl;
+        exit(1);
+    }
+    if (configMap.find("input_format") != configMap.end()) {
+        config.input_format = configMap["input_format"];
+        if (!EdgeReaderFactory::is_supported(config.input_format)) {
+            std::cerr << "Error: unknown input_format " << config.input_format << std::endl;
+            exit(1);
+        }
+    }
+    if (EdgeReaderFactory::is_live(config.input_format) && config.input_data_paths.size() > 1) {
+        std::cerr << "Error: input_format " << config.input_format << " takes a single input_data_path" << std::endl;
+        exit(1);
+    }
+    if (configMap.find("time_encoding") != configMap.end()) {
+        config.time_encoding = configMap["time_encoding"];
+        if (!EdgeReaderFactory::is_supported_time_encoding(config.input_format, config.time_encoding)) {
+            std::cerr << "Error: time_encoding " << config.time_encoding << " is not supported for input_format "
+                    << config.input_format << std::endl;
+            exit(1);
+        }
+    }
+    if (configMap.find("pipelined_ingest") != configMap.end()) {
+        config.pipelined_ingest = std::stoi(configMap["pipelined_ingest"]) != 0;
+    }
+    if (configMap.find("ingest_queue_capacity") != configMap.end()) {
+        config.ingest_queue_capacity = std::stoull(configMap["ingest_queue_capacity"]);
+    }
+    if (configMap.find("checkpoint_path") != configMap.end()) {
+        config.checkpoint_path = configMap["checkpoint_path"];
+    }
+    if (configMap.find("checkpoint_every") != configMap.end()) {
+        config.checkpoint_every = std::stoi(configMap["checkpoint_every"]);
+        if (config.checkpoint_every <= 0) {
+            std::cerr << "Error: checkpoint_every should be > 0" << std::endl;
+            exit(1);
+        }
+    }
+    if (configMap.find("restore_from") != configMap.end()) {
+        config.restore_from = configMap["restore_from"];
+    }
+    if (configMap.find("replay_profile") != configMap.end()) {
+        config.replay_profile = configMap["replay_profile"];
+        config.replay = true;
+    }
+    if (configMap.find("replay_rate") != configMap.end()) {
+        config.replay_rate = std::stod(configMap["replay_rate"]);
+        config.replay = true;
+    }
+    if (configMap.find("replay_speed") != configMap.end()) {
+        config.replay_speed = std::stod(configMap["replay_speed"]);
+        config.replay = true;
+    }
+    if (config.replay) {
+        if (EdgeReaderFactory::is_live(config.input_format)) {
+            std::cerr << "Error: replay_* keys need a recorded input, not input_format " << config.input_format
+                    << std::endl;
+            exit(1);
+        }
+        if (std::string error; !RateProfile::parse(config.replay_profile, config.replay_rate, config.rate_profile, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            exit(1);
+        }
+        config.replay_tag = configMap.find("replay_tag") != configMap.end() ? configMap["replay_tag"] : "replay";
+    }
+    if (configMap.find("max_lateness") != configMap.end()) {
+        config.max_lateness = std::stoll(configMap["max_lateness"]);
+        if (config.max_lateness < 0) {
+            std::cerr << "Error: max_lateness should be >= 0" << std::endl;
+            exit(1);
+        }
+    }
+    if (configMap.find("reorder_capacity") != configMap.end()) {
+        config.reorder_capacity = std::stoull(configMap["reorder_capacity"]);
+        if (config.reorder_capacity == 0) {
+            std::cerr << "Error: reorder_capacity should be > 0" << std::endl;
+            exit(1);
+        }
+    }
+    if (configMap.find("memory_profiler") != configMap.end()) {
+        config.memory_profiler = std::stoi(configMap["memory_profiler"]) != 0;
+    }
+    if (configMap.find("adjacency_store") != configMap.end()) {
+        if (const std::string &store = configMap["adjacency_store"]; store == "slab") {
+            config.adjacency = adjacency_store::slab;
+        } else if (store != "map") {
+            std::cerr << "Error: unknown adjacency_store " << store << std::endl;
+            exit(1);
+        }
+    }
     config.mode = std::stoi(configMap["mode"]);
     config.size = std::stoi(configMap["size"]);
     config.slide = std::stoi(configMap["slide"]);
-    config.query_type = std::stoi(configMap["query_type"]);
     config.path_algorithm = std::stoi(configMap["path_algorithm"]);
 
-    std::istringstream extraArgsStream(configMap["labels"]);
-    std::string arg;
-    while (std::getline(extraArgsStream, arg, ',')) {
-        config.labels.push_back(std::stoi(arg));
+    if (configMap.find("label_map") != configMap.end()) {
+        std::istringstream pairs(configMap["label_map"]);
+        std::string pair;
+        while (std::getline(pairs, pair, ',')) {
+            const std::size_t colon = pair.find(':');
+            try {
+                if (colon == std::string::npos || colon == 0) throw std::invalid_argument(pair);
+                config.label_map[pair.substr(0, colon)] = std::stoll(pair.substr(colon + 1));
+            } catch (const std::exception &) {
+                std::cerr << "Error: label_map entries should be name:id, got " << pair << std::endl;
+                exit(1);
+            }
+        }
+    }
+    if (configMap.find("query") != configMap.end()) {
+        if (configMap.find("query_type") != configMap.end() || configMap.find("labels") != configMap.end()) {
+            std::cerr << "Error: query replaces query_type and labels, set only one of them" << std::endl;
+            exit(1);
+        }
+        config.query = configMap["query"];
+        if (std::string error; !QueryCompiler::compile(config.query, config.label_map, config.compiled_query, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            exit(1);
+        }
+        config.labels = config.compiled_query.labels;
+        config.query_tag = configMap.find("query_tag") != configMap.end() ? configMap["query_tag"] : "custom";
+    } else {
+        config.query_type = std::stoi(configMap["query_type"]);
+        std::istringstream extraArgsStream(configMap["labels"]);
+        std::string arg;
+        while (std::getline(extraArgsStream, arg, ',')) {
+            config.labels.push_back(std::stoi(arg));
+        }
     }
 
     if (config.mode >= 10 and config.mode <= 15) {
@@ -144,13 +295,20 @@ inline config readConfig(const std::string &filename) {
     return config;
 }
 
+// CPU time of the calling thread, in clock() ticks. Matches clock() while the
+// process is single-threaded and leaves out the reader thread's CPU time when
+// pipelined_ingest is enabled.
+inline clock_t processing_clock() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<clock_t>(ts.tv_sec * CLOCKS_PER_SEC + ts.tv_nsec / (1000000000L / CLOCKS_PER_SEC));
+}
+
 // Window class definition
 class window {
 public:
     long long t_open;
     long long t_close;
-    timed_edge *first;
-    timed_edge *last;
     bool evicted = false;
     clock_t start_time; // start time of the window
     double latency = 0.0; // latency of the window
@@ -169,12 +327,10 @@ public:
     int emitted_results = 0;
 
     // Constructor
-    window(long long t_open, long long t_close, timed_edge *first, timed_edge *last, int results_at_open) {
+    window(long long t_open, long long t_close, int results_at_open) {
         this->t_open = t_open;
         this->t_close = t_close;
-        this->first = first;
-        this->last = last;
-        this->start_time = clock();
+        this->start_time = processing_clock();
         this->results_at_open = results_at_open;
         this->results_at_close = results_at_open;
         this->total_matched_results = results_at_open;
@@ -190,6 +346,11 @@ struct Slide {
     int       results_at_open = 0;  // snapshot of matched_paths at slide open
     int       results_at_close = 0; // snapshot of matched_paths at slide close
     double    cost_norm = 0.0;  // cost_norm computed at slide boundary
+    std::uint64_t rehashes_at_open = 0;    // rehash_stats::count at slide open
+    std::uint64_t rehashes_at_close = 0;
+    double    rehash_sec_at_open = 0.0;  // rehash_stats::seconds at slide open
+    double    rehash_sec_at_close = 0.0;
+    memory_usage memory{};      // sampled at slide close, with memory_profiler
 };
 
 // Context structure to hold shared state for mode handlers
@@ -206,6 +367,7 @@ struct ModeContext {
     // CSV output streams
     std::ofstream* csv_tuples;
     std::ofstream* csv_memory;
+    bool memory_profiler = false;
     
     // Configuration values
     long long size;
@@ -273,6 +435,16 @@ struct ModeContext {
 
 };
 
+// Live bytes of the graph, the forests and the result set, and the process RSS.
+inline memory_usage measure_memory(const ModeContext &ctx) {
+    memory_usage m;
+    ctx.sg->measure_memory(m);
+    ctx.q->measure_memory(m);
+    m.sink = ctx.sink->memory();
+    m.rss = process_rss();
+    return m;
+}
+
 // Abstract base class for mode handlers
 class ModeHandler {
 public:
@@ -289,6 +461,10 @@ public:
         ModeContext& ctx, // shared context
         sg_edge** new_sgt_out  // output parameter for the created edge
     ) = 0;
+
+    // Mode-specific state for checkpoints; stateless modes keep the defaults
+    virtual void save(CheckpointWriter&) const {}
+    virtual void load(CheckpointReader&) {}
 };
 
 #endif // MODE_HANDLER_H
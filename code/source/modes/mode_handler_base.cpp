@@ -122,12 +122,15 @@ long long ModeHandlerBase::compute_window_boundaries(ModeContext &ctx, long long
     double o_i = std::floor(static_cast<double>(time) / ctx.slide) * ctx.slide;
     if (o_i > ctx.last_oi) {
         ctx.last_oi = o_i;
-        clock_t now = clock();
+        clock_t now = processing_clock();
 
         // Close the previous slide
         if (!ctx.slides.empty()) {
             ctx.slides.back().wall_close = now;
             ctx.slides.back().results_at_close = ctx.sink->matched_paths;
+            ctx.slides.back().rehashes_at_close = rehash_stats::count;
+            ctx.slides.back().rehash_sec_at_close = rehash_stats::seconds;
+            if (ctx.memory_profiler) ctx.slides.back().memory = measure_memory(ctx);
             // cost_norm will be filled after compute_load_estimation runs
         }
 
@@ -137,6 +140,8 @@ long long ModeHandlerBase::compute_window_boundaries(ModeContext &ctx, long long
         s.t_close    = static_cast<long long>(o_i + ctx.slide);
         s.wall_open  = now;
         s.results_at_open = ctx.sink->matched_paths;
+        s.rehashes_at_open = rehash_stats::count;
+        s.rehash_sec_at_open = rehash_stats::seconds;
         ctx.slides.push_back(s);
         ctx.current_slide_open = s.t_open;
 
@@ -144,8 +149,8 @@ long long ModeHandlerBase::compute_window_boundaries(ModeContext &ctx, long long
             ctx.slides.back().cost_norm = ctx.cost_norm;
         }
 
-        ctx.beta_latency_end = (clock() - ctx.beta_latency_start) / CLOCKS_PER_SEC;
-        ctx.beta_latency_start = clock();
+        ctx.beta_latency_end = (processing_clock() - ctx.beta_latency_start) / CLOCKS_PER_SEC;
+        ctx.beta_latency_start = processing_clock();
         ctx.beta_elements_cont = 0;
     }
 
@@ -169,8 +174,6 @@ long long ModeHandlerBase::compute_window_boundaries(ModeContext &ctx, long long
                             ctx.max_deg_dirty = true;
                         }
                         (ctx.windows)[j].evicted = true;
-                        (ctx.windows)[j].first = nullptr;
-                        (ctx.windows)[j].last = nullptr;
                         (ctx.windows)[j].latency = -1;
                         (ctx.windows)[j].normalized_latency = -1;
                         ctx.windows.pop_back();
@@ -186,7 +189,7 @@ long long ModeHandlerBase::compute_window_boundaries(ModeContext &ctx, long long
                     // paths emitted on this window close
                     (ctx.windows)[ctx.windows.size() - 1].window_matches = (ctx.windows)[ctx.windows.size() - 1].emitted_results;
                 }
-                ctx.windows.emplace_back(window_open, window_close, nullptr, nullptr, ctx.sink->matched_paths);
+                ctx.windows.emplace_back(window_open, window_close, ctx.sink->matched_paths);
             }
         }
 
@@ -196,11 +199,8 @@ long long ModeHandlerBase::compute_window_boundaries(ModeContext &ctx, long long
     return window_close;
 }
 
-bool ModeHandlerBase::update_window(ModeContext &ctx, sg_edge* new_sgt, long long time, long long s) {
+bool ModeHandlerBase::update_window(ModeContext &ctx, long long time, long long s) {
     bool evict = false;
-    auto* t_edge = new timed_edge(new_sgt); // associate the timed edge with the snapshot graph edge
-    ctx.sg->add_timed_edge(t_edge); // append the element to the time list
-    new_sgt->time_pos = t_edge; // associate the snapshot graph edge with the timed edge
 
     // update window boundaries and check for window eviction
     for (size_t i = ctx.window_offset; i < ctx.windows.size(); i++) {
@@ -208,8 +208,8 @@ bool ModeHandlerBase::update_window(ModeContext &ctx, sg_edge* new_sgt, long lon
             // active window
             (ctx.total_elements_count)++;
             (ctx.windows)[i].elements_count++;
-            if (ctx.sg->out_degree[s] > (ctx.windows)[i].max_degree) {
-                (ctx.windows)[i].max_degree = ctx.sg->out_degree[s];
+            if (ctx.sg->out_degree(s) > (ctx.windows)[i].max_degree) {
+                (ctx.windows)[i].max_degree = ctx.sg->out_degree(s);
                 if (ctx.windows[i].max_degree > ctx.max_deg) {
                     ctx.max_deg = ctx.windows[i].max_degree;
                 }
@@ -254,7 +254,7 @@ std::vector<streaming_graph::expired_edge_info> ModeHandlerBase::evict (ModeCont
 void ModeHandlerBase::mark_windows_evicted(ModeContext &ctx) {
     for (unsigned long i: ctx.to_evict) {
         (ctx.windows)[i].evicted = true;
-        ctx.windows[i].latency = static_cast<double>(clock() - (ctx.windows)[i].start_time) / CLOCKS_PER_SEC;
+        ctx.windows[i].latency = static_cast<double>(processing_clock() - (ctx.windows)[i].start_time) / CLOCKS_PER_SEC;
         if ((ctx.windows)[i].latency > ctx.lat_max) ctx.lat_max = (ctx.windows)[i].latency;
         if ((ctx.windows)[i].latency < ctx.lat_min) ctx.lat_min = (ctx.windows)[i].latency;
         (ctx.windows)[i].normalized_latency = ((ctx.windows)[i].latency - ctx.lat_min) / (ctx.lat_max - ctx.lat_min);
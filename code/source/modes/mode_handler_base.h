@@ -12,7 +12,7 @@ protected:
 
     static long long compute_window_boundaries (ModeContext &ctx, long long time);
 
-    static bool update_window (ModeContext &ctx, sg_edge* new_sgt, long long time, long long s);
+    static bool update_window (ModeContext &ctx, long long time, long long s);
 
     static std::vector<streaming_graph::expired_edge_info> evict (ModeContext &ctx, long long time);
 
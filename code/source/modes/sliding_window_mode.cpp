@@ -17,7 +17,7 @@ bool SlidingWindowMode::process_edge(long long s, long long d, long long l, long
     *new_sgt_out = new_sgt;
     
     /* EVICT */
-    if (update_window(ctx, new_sgt, time, s)) {
+    if (update_window(ctx, time, s)) {
         evict(ctx, time);
 
         // mark window as evicted
@@ -0,0 +1,370 @@
+#ifndef ADA_QUERY_COMPILER_H
+#define ADA_QUERY_COMPILER_H
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Minimal DFA of a query, as FiniteStateAutomaton loads it.
+struct query_automaton {
+    int states = 0;                                     // state 0 is the initial state
+    std::vector<std::array<long long, 3> > transitions; // (from, to, label), by state then label
+    std::vector<long long> finals;
+    std::vector<unsigned int> scores;                   // LM-SRPQ landmark score per state
+    std::vector<long long> labels;                      // distinct labels in ascending order
+};
+
+// ---------------------------------------------------------------------------
+// QueryCompiler  —  `query`: RPQ regular expression to minimal DFA
+//
+//   query=(knows|follows)+/likes
+//
+// Operands are label names, resolved through `label_map` (name:id pairs);
+// a name that is not in the map must be a numeric label ID. `/` concatenates,
+// `|` alternates, postfix `*`, `+` and `?` repeat, parentheses group, spaces
+// are ignored. The expression goes through Thompson construction, subset
+// construction and Hopcroft minimization. The empty path never matches (as in
+// the built-in queries), so an accepting initial state is split off into a
+// non-accepting copy before minimizing.
+//
+// A state's score, used by LM-SRPQ landmark selection as the estimated depth
+// of the trees below it, is derived from the loop structure: loop_score for
+// every cycle (strongly connected component with a cycle) reachable from the
+// state and 1 for every edge between two components reachable from it. This
+// only approximates the hand-written scores of the built-in queries, which
+// e.g. give the initial state 0 in most of them; FiniteStateAutomaton replaces
+// the derived scores of an automaton that spells a built-in query by its own.
+// ---------------------------------------------------------------------------
+class QueryCompiler {
+public:
+    static constexpr unsigned int loop_score = 6;
+
+private:
+    struct nfa_state {
+        std::vector<int> eps;
+        std::vector<std::pair<long long, int> > moves; // (label, to)
+    };
+
+    struct fragment {
+        int start, accept;
+    };
+
+    const std::string &query_;
+    const std::unordered_map<std::string, long long> &label_map_;
+    std::size_t pos_ = 0;
+    std::vector<nfa_state> nfa_;
+    std::string error_;
+
+    QueryCompiler(const std::string &query, const std::unordered_map<std::string, long long> &label_map)
+        : query_(query), label_map_(label_map) {}
+
+    int new_state() {
+        nfa_.emplace_back();
+        return static_cast<int>(nfa_.size()) - 1;
+    }
+
+    bool fail(const std::string &what) {
+        if (error_.empty()) error_ = "query: " + what + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    char peek() {
+        while (pos_ < query_.size() && std::isspace(static_cast<unsigned char>(query_[pos_]))) pos_++;
+        return pos_ < query_.size() ? query_[pos_] : '\0';
+    }
+
+    static bool is_name_char(const char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    // Thompson construction, one fragment per grammar rule:
+    //   alternation   := concatenation ('|' concatenation)*
+    //   concatenation := repetition ('/' repetition)*
+    //   repetition    := atom ('*' | '+' | '?')*
+    //   atom          := name | '(' alternation ')'
+    bool alternation(fragment &out) {
+        if (!concatenation(out)) return false;
+        while (peek() == '|') {
+            pos_++;
+            fragment rhs{};
+            if (!concatenation(rhs)) return false;
+            const int s = new_state(), a = new_state();
+            nfa_[s].eps = {out.start, rhs.start};
+            nfa_[out.accept].eps.push_back(a);
+            nfa_[rhs.accept].eps.push_back(a);
+            out = {s, a};
+        }
+        return true;
+    }
+
+    bool concatenation(fragment &out) {
+        if (!repetition(out)) return false;
+        while (peek() == '/') {
+            pos_++;
+            fragment rhs{};
+            if (!repetition(rhs)) return false;
+            nfa_[out.accept].eps.push_back(rhs.start);
+            out.accept = rhs.accept;
+        }
+        return true;
+    }
+
+    bool repetition(fragment &out) {
+        if (!atom(out)) return false;
+        for (char op = peek(); op == '*' || op == '+' || op == '?'; op = peek()) {
+            pos_++;
+            const int s = new_state(), a = new_state();
+            nfa_[s].eps.push_back(out.start);
+            if (op != '+') nfa_[s].eps.push_back(a);
+            if (op != '?') nfa_[out.accept].eps.push_back(out.start);
+            nfa_[out.accept].eps.push_back(a);
+            out = {s, a};
+        }
+        return true;
+    }
+
+    bool atom(fragment &out) {
+        const char c = peek();
+        if (c == '(') {
+            pos_++;
+            if (!alternation(out)) return false;
+            if (peek() != ')') return fail("expected ')'");
+            pos_++;
+            return true;
+        }
+        if (!is_name_char(c)) return fail(c ? std::string("unexpected '") + c + "'" : "unexpected end");
+        const std::size_t begin = pos_;
+        while (pos_ < query_.size() && is_name_char(query_[pos_])) pos_++;
+        const std::string name = query_.substr(begin, pos_ - begin);
+        long long label;
+        if (const auto it = label_map_.find(name); it != label_map_.end()) {
+            label = it->second;
+        } else if (std::all_of(name.begin(), name.end(), [](const char ch) { return std::isdigit(static_cast<unsigned char>(ch)); })) {
+            try {
+                label = std::stoll(name);
+            } catch (const std::exception &) {
+                return fail("label " + name + " out of range");
+            }
+        } else {
+            pos_ = begin;
+            return fail("unknown label " + name + " (not in label_map)");
+        }
+        out = {new_state(), new_state()};
+        nfa_[out.start].moves.emplace_back(label, out.accept);
+        return true;
+    }
+
+    void closure(std::vector<int> &set) const {
+        std::vector<bool> in(nfa_.size(), false);
+        for (const int s : set) in[s] = true;
+        for (std::size_t i = 0; i < set.size(); i++) {
+            for (const int t : nfa_[set[i]].eps) {
+                if (!in[t]) {
+                    in[t] = true;
+                    set.push_back(t);
+                }
+            }
+        }
+        std::sort(set.begin(), set.end());
+    }
+
+    // Subset construction. dfa[s] maps label -> state; DFA state 0 is the
+    // closure of the NFA start.
+    void determinize(const fragment &f, std::vector<std::map<long long, int> > &dfa, std::vector<bool> &accepting) const {
+        std::map<std::vector<int>, int> ids;
+        std::vector<std::vector<int> > sets;
+        std::vector<int> start = {f.start};
+        closure(start);
+        ids[start] = 0;
+        sets.push_back(start);
+        for (std::size_t i = 0; i < sets.size(); i++) {
+            std::map<long long, std::vector<int> > targets;
+            for (const int s : sets[i]) {
+                for (const auto &[label, to] : nfa_[s].moves) targets[label].push_back(to);
+            }
+            dfa.emplace_back();
+            accepting.push_back(std::binary_search(sets[i].begin(), sets[i].end(), f.accept));
+            for (auto &[label, target] : targets) {
+                closure(target);
+                target.erase(std::unique(target.begin(), target.end()), target.end());
+                auto [it, inserted] = ids.emplace(target, static_cast<int>(sets.size()));
+                if (inserted) sets.push_back(target);
+                dfa[i][label] = it->second;
+            }
+        }
+    }
+
+    // Hopcroft minimization over the DFA completed with a dead state; returns
+    // the block of every state. The dead state's block holds no live state,
+    // since every Thompson state reaches the accepting one.
+    static std::vector<int> minimize(const std::vector<std::map<long long, int> > &dfa, const std::vector<bool> &accepting,
+                                     const std::vector<long long> &alphabet) {
+        const int n = static_cast<int>(dfa.size());
+        const int dead = n;
+        std::vector<std::vector<std::vector<int> > > inverse(alphabet.size(), std::vector<std::vector<int> >(n + 1));
+        for (std::size_t c = 0; c < alphabet.size(); c++) {
+            for (int s = 0; s <= n; s++) {
+                int t = dead;
+                if (s != dead) {
+                    if (const auto it = dfa[s].find(alphabet[c]); it != dfa[s].end()) t = it->second;
+                }
+                inverse[c][t].push_back(s);
+            }
+        }
+
+        std::vector<std::vector<int> > blocks(2);
+        for (int s = 0; s <= n; s++) blocks[s != dead && accepting[s] ? 0 : 1].push_back(s);
+        std::vector<int> block_of(n + 1);
+        for (int b = 0; b < 2; b++) {
+            for (const int s : blocks[b]) block_of[s] = b;
+        }
+        std::vector<int> work = {blocks[0].size() <= blocks[1].size() ? 0 : 1};
+        std::vector<bool> in_work = {work[0] == 0, work[0] == 1};
+
+        while (!work.empty()) {
+            const int splitter = work.back();
+            work.pop_back();
+            in_work[splitter] = false;
+            const std::vector<int> members = blocks[splitter];
+            for (std::size_t c = 0; c < alphabet.size(); c++) {
+                // states moving into the splitter on c, grouped by block
+                std::map<int, std::vector<int> > hit;
+                for (const int t : members) {
+                    for (const int s : inverse[c][t]) hit[block_of[s]].push_back(s);
+                }
+                for (auto &[b, moved] : hit) {
+                    if (moved.size() == blocks[b].size()) continue;
+                    std::sort(moved.begin(), moved.end());
+                    std::vector<int> rest;
+                    std::set_difference(blocks[b].begin(), blocks[b].end(), moved.begin(), moved.end(),
+                                        std::back_inserter(rest));
+                    const int nb = static_cast<int>(blocks.size());
+                    blocks[b] = std::move(rest);
+                    blocks.push_back(std::move(moved));
+                    for (const int s : blocks[nb]) block_of[s] = nb;
+                    // a pending block is replaced by both halves, otherwise the smaller half is enough
+                    const int add = in_work[b] || blocks[nb].size() <= blocks[b].size() ? nb : b;
+                    in_work.push_back(false);
+                    work.push_back(add);
+                    in_work[add] = true;
+                }
+            }
+        }
+        std::vector<int> result(block_of.begin(), block_of.end() - 1);
+        for (int &b : result) {
+            if (b == block_of[dead]) b = -1;
+        }
+        return result;
+    }
+
+    static std::vector<unsigned int> derive_scores(const query_automaton &q) {
+        const int n = q.states;
+        std::vector<std::vector<bool> > reach(n, std::vector<bool>(n, false)); // reachable in one or more steps
+        for (const auto &[from, to, label] : q.transitions) reach[from][to] = true;
+        for (int k = 0; k < n; k++) {
+            for (int i = 0; i < n; i++) {
+                if (!reach[i][k]) continue;
+                for (int j = 0; j < n; j++) {
+                    if (reach[k][j]) reach[i][j] = true;
+                }
+            }
+        }
+        // component of a state: its smallest mutually reachable state
+        std::vector<int> component(n);
+        for (int i = 0; i < n; i++) {
+            component[i] = i;
+            for (int j = 0; j < i; j++) {
+                if (reach[i][j] && reach[j][i]) {
+                    component[i] = component[j];
+                    break;
+                }
+            }
+        }
+        std::set<std::pair<int, int> > edges;
+        for (const auto &[from, to, label] : q.transitions) {
+            if (component[from] != component[to]) edges.emplace(component[from], component[to]);
+        }
+        std::vector<unsigned int> scores(n, 0);
+        for (int q0 = 0; q0 < n; q0++) {
+            const auto reachable = [&](const int c) { return c == component[q0] || reach[q0][c]; };
+            for (int c = 0; c < n; c++) {
+                if (component[c] == c && reachable(c) && reach[c][c]) scores[q0] += loop_score;
+            }
+            for (const auto &[from, to] : edges) {
+                if (reachable(from)) scores[q0]++;
+            }
+        }
+        return scores;
+    }
+
+public:
+    // False with a message in error if query is malformed.
+    static bool compile(const std::string &query, const std::unordered_map<std::string, long long> &label_map,
+                        query_automaton &out, std::string &error) {
+        QueryCompiler c(query, label_map);
+        fragment f{};
+        bool ok = c.alternation(f);
+        if (ok && c.peek() != '\0') ok = c.fail(std::string("unexpected '") + c.peek() + "'");
+        if (!ok) {
+            error = c.error_;
+            return false;
+        }
+
+        std::vector<std::map<long long, int> > dfa;
+        std::vector<bool> accepting;
+        c.determinize(f, dfa, accepting);
+        if (accepting[0]) { // the empty path is not a match: start from a non-accepting copy
+            dfa.push_back(dfa[0]);
+            std::swap(dfa.front(), dfa.back());
+            accepting.push_back(true);
+            accepting[0] = false;
+            for (auto &moves : dfa) {
+                for (auto &[label, to] : moves) {
+                    if (to == 0) to = static_cast<int>(dfa.size()) - 1;
+                }
+            }
+        }
+        std::set<long long> alphabet;
+        for (const auto &moves : dfa) {
+            for (const auto &[label, to] : moves) alphabet.insert(label);
+        }
+        const std::vector<int> block = minimize(dfa, accepting, {alphabet.begin(), alphabet.end()});
+
+        // number the blocks breadth-first from the initial state, labels in ascending order
+        std::vector<int> number(dfa.size() + 1, -1);
+        std::vector<int> representative;
+        std::deque<int> queue = {0};
+        number[block[0]] = 0;
+        representative.push_back(0);
+        while (!queue.empty()) {
+            const int s = queue.front();
+            queue.pop_front();
+            for (const auto &[label, to] : dfa[s]) {
+                if (number[block[to]] >= 0) continue;
+                number[block[to]] = static_cast<int>(representative.size());
+                representative.push_back(to);
+                queue.push_back(to);
+            }
+        }
+
+        out = {};
+        out.states = static_cast<int>(representative.size());
+        for (int state = 0; state < out.states; state++) {
+            const int s = representative[state];
+            if (accepting[s]) out.finals.push_back(state);
+            for (const auto &[label, to] : dfa[s]) out.transitions.push_back({state, number[block[to]], label});
+        }
+        out.labels.assign(alphabet.begin(), alphabet.end());
+        out.scores = derive_scores(out);
+        return true;
+    }
+};
+
+#endif //ADA_QUERY_COMPILER_H
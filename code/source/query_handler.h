@@ -29,12 +29,14 @@ public:
             edge->s, edge->d, edge->label, edge->timestamp);
     }
 
-    // Expire state after sliding the window.
+    // Expire state after sliding the window, then shrink the tables the
+    // expiration emptied.
     void update_state(
         long long eviction_time,
         const std::vector<streaming_graph::expired_edge_info>& deleted_edges) const
     {
         processor_->expire_forest(eviction_time, deleted_edges);
+        processor_->compact();
     }
 
     // Handle mid-window edge deletion (load shedding).
@@ -43,4 +45,23 @@ public:
     {
         processor_->shed_edges(deleted_edges);
     }
+
+    // True while the forests still reference vertex v.
+    [[nodiscard]] bool holds_vertex(unsigned int v) const {
+        return processor_->holds_vertex(v);
+    }
+
+    // Memory accounting of the forests of the selected algorithm.
+    void measure_memory(memory_usage& m) const {
+        processor_->measure_memory(m);
+    }
+
+    // Checkpoint the forests of the selected algorithm.
+    void save(CheckpointWriter& w) const {
+        processor_->save(w);
+    }
+
+    void load(CheckpointReader& r) const {
+        processor_->load(r);
+    }
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -33,18 +34,36 @@ public:
     // tries to reconnect them via alternative paths still in the graph.
     virtual void shed_edges(
         const std::vector<streaming_graph::expired_edge_info>& deleted_edges) = 0;
+
+    // True while the forests still reference vertex v, so that its dense ID
+    // must not be reclaimed by the VertexDictionary.
+    [[nodiscard]] virtual bool holds_vertex(unsigned int v) const = 0;
+
+    // Shrinks the hash tables that lost most of their elements. Erasures
+    // never rehash; this runs once per slide, after expiration.
+    virtual void compact() = 0;
+
+    // Adds the live bytes of the forests and their indexes to m.
+    virtual void measure_memory(memory_usage& m) const = 0;
+
+    // Write / restore the complete algorithm state for a checkpoint. load is
+    // only called on a freshly constructed processor.
+    virtual void save(CheckpointWriter& w) const = 0;
+    virtual void load(CheckpointReader& r) = 0;
 };
 
 // ---------------------------------------------------------------------------
 // SPathProcessor  —  wraps S_PATH
 // ---------------------------------------------------------------------------
+template<unsigned int N>
 class SPathProcessor final : public IQueryProcessor {
-    S_PATH impl_;
+    S_PATH<N> impl_;
 
 public:
     SPathProcessor(FiniteStateAutomaton& fsa, streaming_graph& sg, Sink& sink)
         : impl_(fsa, sg, sink) {}
 
+    // s and d are dense VertexDictionary IDs and fit in 32 bits.
     bool insert_edge(long long s, long long d, long long label,
                      long long timestamp) override {
         return impl_.insert_edge(
@@ -64,6 +83,26 @@ public:
         const std::vector<streaming_graph::expired_edge_info>& deleted_edges) override {
         impl_.shed_edges(deleted_edges);
     }
+
+    [[nodiscard]] bool holds_vertex(unsigned int v) const override {
+        return impl_.holds_vertex(v);
+    }
+
+    void compact() override {
+        impl_.compact();
+    }
+
+    void measure_memory(memory_usage& m) const override {
+        impl_.measure_memory(m);
+    }
+
+    void save(CheckpointWriter& w) const override {
+        impl_.save(w);
+    }
+
+    void load(CheckpointReader& r) override {
+        impl_.load(r);
+    }
 };
 
 // ---------------------------------------------------------------------------
@@ -72,8 +111,9 @@ public:
 // dynamic_lm_select is called inside expire_forest so callers remain unaware
 // of the landmark-maintenance step that is specific to this algorithm.
 // ---------------------------------------------------------------------------
+template<unsigned int N>
 class LmSrpqProcessor final : public IQueryProcessor {
-    LM_SRPQ impl_;
+    LM_SRPQ<N> impl_;
     double candidate_rate_;
     double benefit_threshold_;
 
@@ -85,6 +125,7 @@ public:
         , candidate_rate_(candidate_rate)
         , benefit_threshold_(benefit_threshold) {}
 
+    // s and d are dense VertexDictionary IDs and fit in 32 bits.
     bool insert_edge(long long s, long long d, long long label,
                      long long timestamp) override {
         impl_.insert_edge(
@@ -110,6 +151,26 @@ public:
         // with a max eviction_time so the timestamp check is effectively disabled.
         impl_.expire_forest(0, deleted_edges);
     }
+
+    [[nodiscard]] bool holds_vertex(unsigned int v) const override {
+        return impl_.holds_vertex(v);
+    }
+
+    void compact() override {
+        impl_.compact();
+    }
+
+    void measure_memory(memory_usage& m) const override {
+        impl_.measure_memory(m);
+    }
+
+    void save(CheckpointWriter& w) const override {
+        impl_.save(w);
+    }
+
+    void load(CheckpointReader& r) override {
+        impl_.load(r);
+    }
 };
 
 // ---------------------------------------------------------------------------
@@ -118,6 +179,14 @@ public:
 // Algorithm registry:
 //   1  →  S-PATH
 //   2  →  LM-SRPQ
+//
+// Both are instantiated per automaton state count, so that the forests index
+// their nodes by state with a plain array (see RPQ_tree). Shape registry:
+//   2  →  a+, ab*, (a|b)c*
+//   3  →  ab*c, abc*, a*b*, ab*c*, (a|b)+c
+//   4  →  (abc)+
+// Automata with another state count, e.g. from a `query` expression, run on
+// the N = 0 instantiation, whose trees size their state tables at run time.
 // ---------------------------------------------------------------------------
 class QueryProcessorFactory {
 public:
@@ -136,13 +205,36 @@ public:
         streaming_graph& sg,
         Sink& sink,
         LmSrpqConfig lm_cfg = {0.2, 1.5})
+    {
+        using creator = std::unique_ptr<IQueryProcessor> (*)(
+            int, FiniteStateAutomaton&, streaming_graph&, Sink&, LmSrpqConfig);
+        static constexpr std::array<std::pair<int, creator>, 3> shapes = {{
+            {2, &create_for<2>},
+            {3, &create_for<3>},
+            {4, &create_for<4>},
+        }};
+        for (const auto& [states, create_shape] : shapes) {
+            if (states == fsa.states())
+                return create_shape(algorithm, fsa, sg, sink, lm_cfg);
+        }
+        return create_for<0>(algorithm, fsa, sg, sink, lm_cfg);
+    }
+
+private:
+    template<unsigned int N>
+    static std::unique_ptr<IQueryProcessor> create_for(
+        int algorithm,
+        FiniteStateAutomaton& fsa,
+        streaming_graph& sg,
+        Sink& sink,
+        LmSrpqConfig lm_cfg)
     {
         switch (algorithm) {
             case ALGO_S_PATH:
-                return std::make_unique<SPathProcessor>(fsa, sg, sink);
+                return std::make_unique<SPathProcessor<N>>(fsa, sg, sink);
 
             case ALGO_LM_SRPQ:
-                return std::make_unique<LmSrpqProcessor>(
+                return std::make_unique<LmSrpqProcessor<N>>(
                     fsa, sg, sink,
                     lm_cfg.candidate_rate,
                     lm_cfg.benefit_threshold);
@@ -154,6 +246,6 @@ public:
         }
     }
 
-private:
+
     QueryProcessorFactory() = delete; // pure static utility — not instantiable
 };
@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include "buckets.h"
+#include "../checkpoint_io.h"
 
 void RankBuckets::set_rank(Id id, int newRank) {
 
@@ -75,3 +76,15 @@ void RankBuckets::remove_from_bucket(Id id, double rank, std::size_t pos) {
         meta_[moved].pos = pos;
     }
 }
+
+void RankBuckets::save(CheckpointWriter &w) const {
+    w.put_size(buckets_.size());
+    for (const auto &b : buckets_) w.put_vector(b);
+    w.put_map(meta_);
+}
+
+void RankBuckets::load(CheckpointReader &r) {
+    buckets_.resize(r.get_size());
+    for (auto &b : buckets_) r.get_vector(b);
+    r.get_map(meta_);
+}
@@ -6,6 +6,9 @@
 #include <unordered_map>
 #include <cstddef>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class RankBuckets {
 public:
     using Id = std::int64_t;
@@ -21,6 +24,10 @@ public:
 
     [[nodiscard]] std::vector<Id> top_k(std::size_t k) const;
 
+    void save(CheckpointWriter &w) const;
+
+    void load(CheckpointReader &r);
+
 private:
     struct Meta {
         double rank = kNoRank;
@@ -6,6 +6,10 @@
 #include <string>
 #include <fstream>
 
+#include "checkpoint_io.h"
+#include "memory_usage.h"
+#include "vertex_dictionary.h"
+
 struct result {
     long long destination;
     long long timestamp;
@@ -23,6 +27,7 @@ struct resultHash {
 
 class Sink {
     std::unordered_map<long long, std::unordered_set<result, resultHash> > result_set;
+    const VertexDictionary *vertices = nullptr; // dense -> external IDs; results are kept with external IDs
 
 public:
     int matched_paths = 0; // patterns matched
@@ -37,9 +42,24 @@ public:
         return size;
     }
 
+    // live bytes of the result set
+    [[nodiscard]] std::size_t memory() const {
+        std::size_t total = memory_estimate::hashed(result_set);
+        for (const auto &[source, destinations]: result_set) total += memory_estimate::hashed(destinations);
+        return total;
+    }
+
+    void setVertexDictionary(const VertexDictionary *dictionary) {
+        vertices = dictionary;
+    }
+
     // add entry in result set
     void addEntry(long long source, long long destination, long long timestamp) {
         // if (source == destination) return; // avoid self loops
+        if (vertices) { // dense IDs are reused after their vertex leaves the window
+            source = vertices->external(source);
+            destination = vertices->external(destination);
+        }
         result res = {destination, timestamp};
         auto& destinations = result_set[source];
 
@@ -52,6 +72,28 @@ public:
     }
 
 
+    void save(CheckpointWriter &w) const {
+        w.put(matched_paths);
+        w.put(total_matches);
+        w.put_size(result_set.size());
+        for (const auto &[source, destinations]: result_set) {
+            w.put(source);
+            w.put_size(destinations.size());
+            for (const auto &res: destinations) w.put(res);
+        }
+    }
+
+    void load(CheckpointReader &r) {
+        r.get(matched_paths);
+        r.get(total_matches);
+        for (std::size_t i = r.get_size(); i > 0; i--) {
+            auto &destinations = result_set[r.get<long long>()];
+            const std::size_t n = r.get_size();
+            destinations.reserve(n);
+            for (std::size_t j = 0; j < n; j++) destinations.insert(r.get<result>());
+        }
+    }
+
     void refresh_resultSet(long long timestamp) {
         // delete all the entries with timestamp less than the given timestamp
         for (auto it = result_set.begin(); it != result_set.end();) {
@@ -1,23 +1,30 @@
 #ifndef STREAMING_GRAPH_H
 #define STREAMING_GRAPH_H
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <new>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <iostream>
 #include <map>
 
+#include "checkpoint_io.h"
+#include "memory_usage.h"
 #include "ranking/buckets.h"
 
-struct timed_edge;
-
 struct sg_edge {
     long long label;
     long long timestamp;
     long long expiration_time;
-    timed_edge *time_pos;
     long long s, d;
     long long id;
+    std::uint32_t out_slot = 0, in_slot = 0; // record positions in the adjacency store
+    std::uint32_t pane = 0;     // sequence number of the pane holding the edge (see EdgePanes)
+    bool queued = false;        // still in the time list: not expired, removed or relocated
 
     sg_edge(const long long id_, const long long src, const long long dst, const long long label_, const long long time, const long long expiration_time_) {
         id = id_;
@@ -25,19 +32,167 @@ struct sg_edge {
         d = dst;
         timestamp = time;
         label = label_;
-        time_pos = nullptr;
         expiration_time = expiration_time_;
     }
 };
 
-struct timed_edge {
-    timed_edge *next;
-    timed_edge *prev; // the two pointers to maintain the double linked list;
-    sg_edge *edge_pt; // pointer to the sg edge;
-    explicit timed_edge(sg_edge *edge) {
-        edge_pt = edge;
-        next = nullptr;
-        prev = nullptr;
+// ---------------------------------------------------------------------------
+// EdgePanes  —  storage and expiration queue of the window's edges, grouped
+// into per-slide panes
+//
+// Each pane owns an arena of fixed-size chunks in which its edges are
+// constructed in arrival order; a new pane opens when an edge's timestamp
+// reaches the next multiple of the pane width (the slide). The panes thus
+// double as the time list: expiration reads them front to back, sequentially.
+// An edge leaves the queue by expiring, by being removed out of order (load
+// shedding) or by being refreshed, in which case it is copied to the newest
+// pane. Its memory stays valid until its pane is released: a pane whose edges
+// have all left is released as a unit, chunks going to a spare list, when the
+// next pane opens.
+// ---------------------------------------------------------------------------
+class EdgePanes {
+    static constexpr std::size_t chunk_edges = 512;
+    static constexpr std::size_t max_spare_chunks = 64;
+
+    struct chunk {
+        alignas(sg_edge) unsigned char bytes[chunk_edges * sizeof(sg_edge)];
+    };
+
+    struct pane {
+        long long key;                              // timestamp / width of the pane
+        std::vector<std::unique_ptr<chunk> > chunks;
+        std::size_t size = 0;                       // slots handed out
+        std::size_t head = 0;                       // first slot that may still be queued
+        std::size_t live = 0;                       // queued edges
+    };
+
+    std::deque<pane> panes_;
+    std::uint32_t first_ = 0; // sequence number of panes_.front()
+    std::vector<std::unique_ptr<chunk> > spare_;
+    std::size_t live_ = 0;
+    long long width_;
+
+    static sg_edge *at(const pane &p, const std::size_t i) {
+        return std::launder(reinterpret_cast<sg_edge *>(p.chunks[i / chunk_edges]->bytes) + i % chunk_edges);
+    }
+
+    pane &pane_of(const sg_edge *edge) {
+        return panes_[static_cast<std::uint32_t>(edge->pane - first_)];
+    }
+
+    // Releases the chunks of every drained pane but the newest, and drops
+    // drained panes off the front.
+    void reclaim() {
+        for (std::size_t i = 0; i + 1 < panes_.size(); i++) {
+            pane &p = panes_[i];
+            if (p.live != 0 || p.chunks.empty()) continue;
+            for (auto &c : p.chunks) {
+                if (spare_.size() < max_spare_chunks) spare_.push_back(std::move(c));
+            }
+            p.chunks.clear();
+            p.size = p.head = 0;
+        }
+        while (panes_.size() > 1 && panes_.front().live == 0) {
+            panes_.pop_front();
+            first_++;
+        }
+    }
+
+    // Slot for a new edge with the given timestamp, in the newest pane.
+    void *allocate(const long long timestamp) {
+        const long long key = timestamp / width_;
+        if (panes_.empty() || key > panes_.back().key) {
+            reclaim();
+            panes_.emplace_back().key = key;
+        }
+        pane &p = panes_.back();
+        if (p.size == p.chunks.size() * chunk_edges) {
+            if (spare_.empty()) {
+                p.chunks.emplace_back(new chunk);
+            } else {
+                p.chunks.push_back(std::move(spare_.back()));
+                spare_.pop_back();
+            }
+        }
+        return p.chunks[p.size / chunk_edges]->bytes + p.size % chunk_edges * sizeof(sg_edge);
+    }
+
+    sg_edge *enqueue(sg_edge *edge) {
+        pane &p = panes_.back();
+        edge->pane = first_ + static_cast<std::uint32_t>(panes_.size() - 1);
+        edge->queued = true;
+        p.size++;
+        p.live++;
+        live_++;
+        return edge;
+    }
+
+public:
+    explicit EdgePanes(const long long width) : width_(width > 0 ? width : 1) {}
+
+    EdgePanes(const EdgePanes &) = delete;
+    EdgePanes &operator=(const EdgePanes &) = delete;
+
+    // Constructs a new edge at the back of the queue.
+    sg_edge *create(const long long id, const long long s, const long long d, const long long label,
+                    const long long timestamp, const long long expiration_time) {
+        void *slot = allocate(timestamp);
+        return enqueue(::new(slot) sg_edge(id, s, d, label, timestamp, expiration_time));
+    }
+
+    // Moves a refreshed edge to the back of the queue; returns its new
+    // address; the caller repoints the indexes that held the old one.
+    sg_edge *relocate(sg_edge *edge) {
+        void *slot = allocate(edge->timestamp);
+        sg_edge *moved = enqueue(::new(slot) sg_edge(*edge));
+        erase(edge);
+        return moved;
+    }
+
+    // Takes edge out of the queue; false if it had already left.
+    bool erase(sg_edge *edge) {
+        if (!edge->queued) return false;
+        edge->queued = false;
+        pane_of(edge).live--;
+        live_--;
+        return true;
+    }
+
+    // Oldest queued edge, or nullptr if the queue is empty.
+    [[nodiscard]] sg_edge *front() {
+        for (pane &p : panes_) {
+            while (p.head < p.size && !at(p, p.head)->queued) p.head++;
+            if (p.head < p.size) return at(p, p.head);
+        }
+        return nullptr;
+    }
+
+    void pop_front() {
+        if (sg_edge *edge = front()) erase(edge);
+    }
+
+    // Calls f(sg_edge *) for every queued edge, oldest first.
+    template<typename F>
+    void for_each(F &&f) const {
+        for (const pane &p : panes_) {
+            for (std::size_t i = p.head; i < p.size; i++) {
+                if (sg_edge *edge = at(p, i); edge->queued) f(edge);
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return live_;
+    }
+
+    [[nodiscard]] std::size_t pane_count() const {
+        return panes_.size();
+    }
+
+    [[nodiscard]] std::size_t memory() const {
+        std::size_t chunks = spare_.size();
+        for (const pane &p : panes_) chunks += p.chunks.size();
+        return chunks * sizeof(chunk) + panes_.size() * sizeof(pane);
     }
 };
 
@@ -50,30 +205,303 @@ struct pair_hash_aj {
     }
 };
 
-struct MemoryEstimatorAdjL {
-    static constexpr size_t ptr_size = sizeof(void *);
-    static constexpr size_t node_overhead = 2 * sizeof(void *); // approx. per unordered_map node
+// (from, to, label) identity of an edge in the window
+struct edge_key {
+    long long s, d, label;
+
+    bool operator==(const edge_key &o) const {
+        return s == o.s && d == o.d && label == o.label;
+    }
+};
+
+struct edge_key_hash {
+    std::size_t operator()(const edge_key &k) const {
+        std::size_t h = std::hash<long long>()(k.s);
+        h ^= std::hash<long long>()(k.d) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= std::hash<long long>()(k.label) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// `adjacency_store` config key
+enum class adjacency_store { map, slab };
+
+// One adjacency record as seen by the neighbor callbacks: vertex is the other
+// endpoint (d for successors, s for predecessors).
+struct neighbor {
+    long long vertex;
+    long long label;
+    long long timestamp;
+    sg_edge *edge;
+};
+
+// Both adjacency stores partition each vertex's records by label, so an
+// expansion from a product-graph node (v, q) only visits the labels with a
+// transition out of q. A vertex has a handful of partitions at most (edges
+// with labels outside the query never reach the graph); they are kept in
+// first-seen order and dropped when they run empty.
+
+// ---------------------------------------------------------------------------
+// MapAdjacency  —  `adjacency_store=map`: hashed per-vertex neighbor lists of
+// (other endpoint, edge) pairs
+//
+// Each edge remembers its position in its partition through the sg_edge member
+// given as slot, so removal swaps the last record into the hole.
+// ---------------------------------------------------------------------------
+class MapAdjacency {
+public:
+    struct label_partition {
+        long long label;
+        std::vector<std::pair<long long, sg_edge *> > edges;
+    };
+
+    using neighbor_list = std::vector<label_partition>;
+
+private:
+    std::unordered_map<long long, neighbor_list> lists_;
+    std::uint32_t sg_edge::*slot_;
+    bool successors_; // pairs hold d (successors) or s (predecessors)
+
+    template<typename List>
+    static auto find_partition(List &list, const long long label) {
+        return std::find_if(list.begin(), list.end(), [&](const label_partition &p) { return p.label == label; });
+    }
+
+public:
+    MapAdjacency(std::uint32_t sg_edge::*slot, const bool successors) : slot_(slot), successors_(successors) {}
+
+    void append(const long long v, sg_edge *e) {
+        neighbor_list &list = lists_[v];
+        auto p = find_partition(list, e->label);
+        if (p == list.end()) p = list.insert(list.end(), label_partition{e->label, {}});
+        e->*slot_ = static_cast<std::uint32_t>(p->edges.size());
+        p->edges.emplace_back(successors_ ? e->d : e->s, e);
+    }
+
+    void erase(const long long v, const sg_edge *e) {
+        const auto it = lists_.find(v);
+        if (it == lists_.end()) return;
+        neighbor_list &list = it->second;
+        const auto p = find_partition(list, e->label);
+        if (p == list.end()) return;
+        if (const std::uint32_t slot = e->*slot_; slot + 1 < p->edges.size()) {
+            p->edges[slot] = p->edges.back();
+            p->edges[slot].second->*slot_ = slot;
+        }
+        p->edges.pop_back();
+        if (p->edges.empty()) list.erase(p);
+        if (list.empty()) lists_.erase(it);
+    }
+
+    // Timestamps are read through the edge pointers.
+    void set_timestamp(long long, const sg_edge *) {}
+
+    // Points the record of from at to instead (same slot, same label).
+    void replace(const long long v, const sg_edge *from, sg_edge *to) {
+        find_partition(lists_.find(v)->second, from->label)->edges[from->*slot_].second = to;
+    }
+
+    [[nodiscard]] std::size_t degree(const long long v) const {
+        const auto it = lists_.find(v);
+        if (it == lists_.end()) return 0;
+        std::size_t n = 0;
+        for (const label_partition &p : it->second) n += p.edges.size();
+        return n;
+    }
+
+    template<typename F>
+    void for_each(const long long v, F &&f) const {
+        const auto it = lists_.find(v);
+        if (it == lists_.end()) return;
+        for (const label_partition &p : it->second) {
+            for (const auto &[vertex, edge] : p.edges) f(neighbor{vertex, p.label, edge->timestamp, edge});
+        }
+    }
+
+    template<typename F>
+    void for_each(const long long v, const long long label, F &&f) const {
+        const auto it = lists_.find(v);
+        if (it == lists_.end()) return;
+        const auto p = find_partition(it->second, label);
+        if (p == it->second.end()) return;
+        for (const auto &[vertex, edge] : p->edges) f(neighbor{vertex, label, edge->timestamp, edge});
+    }
 
-    // size of one sg_edge object
-    static size_t size_of_sg_edge() {
-        return sizeof(sg_edge);
+    // Calls f(label, count) for every partition of v.
+    template<typename F>
+    void for_each_label(const long long v, F &&f) const {
+        const auto it = lists_.find(v);
+        if (it == lists_.end()) return;
+        for (const label_partition &p : it->second) f(p.label, p.edges.size());
     }
 
-    // estimate memory for unordered_map<long long, vector<pair<long long, sg_edge*>>>
-    static size_t estimate_adjacency_list(
-        const std::unordered_map<long long, std::vector<std::pair<long long, sg_edge *> > > &m) {
-        size_t total = 0;
-        // bucket array
-        total += m.bucket_count() * ptr_size;
+    template<typename F>
+    void for_each_vertex(F &&f) const {
+        for (const auto &[v, list] : lists_) f(v);
+    }
 
-        for (const auto &kv: m) {
-            total += sizeof(long long); // key
-            total += sizeof(std::vector<std::pair<long long, sg_edge *> >); // vector object
-            total += node_overhead; // unordered_map node overhead
+    [[nodiscard]] std::size_t vertex_count() const {
+        return lists_.size();
+    }
 
-            const auto &vec = kv.second;
-            // vector capacity (not just size!) times element size
-            total += vec.capacity() * sizeof(std::pair<long long, sg_edge *>);
+    [[nodiscard]] std::size_t memory() const {
+        std::size_t total = memory_estimate::hashed(lists_);
+        for (const auto &[v, list] : lists_) {
+            total += memory_estimate::vector(list);
+            for (const label_partition &p : list) total += memory_estimate::vector(p.edges);
+        }
+        return total;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// SlabAdjacency  —  `adjacency_store=slab`: contiguous slabs of edge records
+// per (dense) vertex ID and label, in structure-of-arrays form
+//
+// A neighbor scan reads the vertex and timestamp columns sequentially and
+// only touches an sg_edge when the caller does. Removal leaves a tombstone (a
+// null edge pointer); a slab is compacted in place, keeping the record order,
+// once tombstones outnumber live records. Each edge remembers its position in
+// its slab through the sg_edge member given as slot.
+// ---------------------------------------------------------------------------
+class SlabAdjacency {
+    struct slab {
+        long long label = 0;
+        std::vector<long long> vertex;
+        std::vector<long long> timestamp;
+        std::vector<sg_edge *> edge; // nullptr: tombstone
+        std::size_t live = 0;
+    };
+
+    static constexpr std::size_t compaction_min = 8;
+
+    std::vector<std::vector<slab> > slabs_; // vertex -> one slab per label
+    std::uint32_t sg_edge::*slot_;
+    bool successors_; // vertex column holds d (successors) or s (predecessors)
+
+    [[nodiscard]] const std::vector<slab> *slabs_of(const long long v) const {
+        return static_cast<std::size_t>(v) < slabs_.size() ? &slabs_[v] : nullptr;
+    }
+
+    template<typename Slabs>
+    static auto find_slab(Slabs &slabs, const long long label) {
+        return std::find_if(slabs.begin(), slabs.end(), [&](const slab &sl) { return sl.label == label; });
+    }
+
+    void compact(slab &sl) {
+        std::size_t out = 0;
+        for (std::size_t i = 0; i < sl.edge.size(); i++) {
+            if (!sl.edge[i]) continue;
+            if (out != i) {
+                sl.vertex[out] = sl.vertex[i];
+                sl.timestamp[out] = sl.timestamp[i];
+                sl.edge[out] = sl.edge[i];
+                sl.edge[out]->*slot_ = static_cast<std::uint32_t>(out);
+            }
+            out++;
+        }
+        sl.vertex.resize(out);
+        sl.timestamp.resize(out);
+        sl.edge.resize(out);
+    }
+
+    template<typename F>
+    static void scan(const slab &sl, F &f) {
+        for (std::size_t i = 0; i < sl.edge.size(); i++) {
+            if (sl.edge[i]) f(neighbor{sl.vertex[i], sl.label, sl.timestamp[i], sl.edge[i]});
+        }
+    }
+
+public:
+    SlabAdjacency(std::uint32_t sg_edge::*slot, const bool successors) : slot_(slot), successors_(successors) {}
+
+    void append(const long long v, sg_edge *e) {
+        if (static_cast<std::size_t>(v) >= slabs_.size()) slabs_.resize(v + 1);
+        std::vector<slab> &slabs = slabs_[v];
+        auto sl = find_slab(slabs, e->label);
+        if (sl == slabs.end()) {
+            sl = slabs.insert(slabs.end(), slab{});
+            sl->label = e->label;
+        }
+        e->*slot_ = static_cast<std::uint32_t>(sl->edge.size());
+        sl->vertex.push_back(successors_ ? e->d : e->s);
+        sl->timestamp.push_back(e->timestamp);
+        sl->edge.push_back(e);
+        sl->live++;
+    }
+
+    void erase(const long long v, const sg_edge *e) {
+        std::vector<slab> &slabs = slabs_[v];
+        const auto sl = find_slab(slabs, e->label);
+        sl->edge[e->*slot_] = nullptr;
+        if (--sl->live == 0) {
+            slabs.erase(sl);
+        } else if (sl->edge.size() >= compaction_min && 2 * sl->live < sl->edge.size()) {
+            compact(*sl);
+        }
+    }
+
+    void set_timestamp(const long long v, const sg_edge *e) {
+        find_slab(slabs_[v], e->label)->timestamp[e->*slot_] = e->timestamp;
+    }
+
+    // Points the record of from at to instead (same slot, same label).
+    void replace(const long long v, const sg_edge *from, sg_edge *to) {
+        find_slab(slabs_[v], from->label)->edge[from->*slot_] = to;
+    }
+
+    [[nodiscard]] std::size_t degree(const long long v) const {
+        std::size_t n = 0;
+        if (const std::vector<slab> *slabs = slabs_of(v)) {
+            for (const slab &sl : *slabs) n += sl.live;
+        }
+        return n;
+    }
+
+    template<typename F>
+    void for_each(const long long v, F &&f) const {
+        if (const std::vector<slab> *slabs = slabs_of(v)) {
+            for (const slab &sl : *slabs) scan(sl, f);
+        }
+    }
+
+    template<typename F>
+    void for_each(const long long v, const long long label, F &&f) const {
+        const std::vector<slab> *slabs = slabs_of(v);
+        if (!slabs) return;
+        if (const auto sl = find_slab(*slabs, label); sl != slabs->end()) scan(*sl, f);
+    }
+
+    // Calls f(label, count) for every slab of v.
+    template<typename F>
+    void for_each_label(const long long v, F &&f) const {
+        if (const std::vector<slab> *slabs = slabs_of(v)) {
+            for (const slab &sl : *slabs) f(sl.label, sl.live);
+        }
+    }
+
+    // Calls f(v) for every vertex with at least one record, in ID order.
+    template<typename F>
+    void for_each_vertex(F &&f) const {
+        for (std::size_t v = 0; v < slabs_.size(); v++) {
+            if (!slabs_[v].empty()) f(static_cast<long long>(v));
+        }
+    }
+
+    [[nodiscard]] std::size_t vertex_count() const {
+        std::size_t n = 0;
+        for (const std::vector<slab> &slabs : slabs_) n += !slabs.empty();
+        return n;
+    }
+
+    [[nodiscard]] std::size_t memory() const {
+        std::size_t total = memory_estimate::vector(slabs_);
+        for (const std::vector<slab> &slabs : slabs_) {
+            total += memory_estimate::vector(slabs);
+            for (const slab &sl : slabs) {
+                total += memory_estimate::vector(sl.vertex) + memory_estimate::vector(sl.timestamp) +
+                        memory_estimate::vector(sl.edge);
+            }
         }
         return total;
     }
@@ -87,309 +515,362 @@ public:
 
     int shed_count = 0;
 
-    std::unordered_map<long long, std::vector<std::pair<long long, sg_edge *> > > adjacency_list;
-    std::unordered_map<long long, std::vector<std::pair<long long, sg_edge *> > > reverse_adjacency_list; // dst -> [(src, edge*), ...]
-
     double edge_num = 0; // number of edges in the window
     int EINIT_count = 0;
-    std::unordered_map<long long, long long> label_count;
+    std::vector<long long> label_count; // label -> edges in the window
 
-    timed_edge *time_list_head = nullptr; // head of the time sequence list;
-    timed_edge *time_list_tail = nullptr; // tail of the time sequence list
+    EdgePanes time_list; // the window's edges in arrival order, grouped by slide
 
     std::unordered_set<long long> initial_transitions; // labels that can start the query
 
-    std::unordered_map<long long, int> in_degree;
-    std::unordered_map<long long, int> out_degree;
     double vertex_num = 0; // number of vertices in the window
+    std::vector<long long> isolated_vertices; // vertices that lost their last edge, drained by the caller
+
+private:
+    // Per-vertex state, indexed by dense vertex ID (see VertexDictionary). A
+    // vertex is in the window while it has an edge; its per-label degrees
+    // are the sizes of its adjacency partitions.
+    struct vertex_record {
+        int out_degree = 0;
+        int in_degree = 0;
+
+        [[nodiscard]] bool present() const {
+            return out_degree != 0 || in_degree != 0;
+        }
+    };
 
-    // Lookup from the edge_id to the edge in the adjacency list
-    std::unordered_map<long long, sg_edge *> edge_id_to_edge;
+    std::vector<vertex_record> vertices_;
 
-    // edge_id -> (src, dst)
-    std::unordered_map<long long, std::pair<long long, long long> > edge_endpoints;
+    // edge_id -> edge, kept only when the constructor asks for it (load
+    // shedding looks up the edges its ranking picks)
+    bool index_edge_ids_;
+    std::unordered_map<long long, sg_edge *> edge_ids_;
 
-    explicit streaming_graph(const std::vector<long long>& initial_transitions_) {
-        for (const auto label : initial_transitions_) {
-            initial_transitions.insert(label);
-        }
+    adjacency_store store_;
+    MapAdjacency out_lists_{&sg_edge::out_slot, true};  // src -> [(dst, edge*), ...]
+    MapAdjacency in_lists_{&sg_edge::in_slot, false};   // dst -> [(src, edge*), ...]
+
+    // (from, to, label) -> edge, for constant-time duplicate checks and removal
+    std::unordered_map<edge_key, sg_edge *, edge_key_hash> edge_index_;
+
+    SlabAdjacency out_slabs_{&sg_edge::out_slot, true};
+    SlabAdjacency in_slabs_{&sg_edge::in_slot, false};
+
+    // Calls f with the active out-edge (in-edge) store; both share one interface.
+    template<typename F>
+    decltype(auto) outgoing(F &&f) const {
+        return store_ == adjacency_store::slab ? f(out_slabs_) : f(out_lists_);
     }
 
-    [[nodiscard]] bool is_initial_transition(const long long label) const {
-        return initial_transitions.find(label) != initial_transitions.end();
+    template<typename F>
+    decltype(auto) incoming(F &&f) const {
+        return store_ == adjacency_store::slab ? f(in_slabs_) : f(in_lists_);
     }
 
-    ~streaming_graph() {
-        // Free memory for all edges in the adjacency list
-        for (auto &[_, edges]: adjacency_list) {
-            for (auto &[_, edge]: edges) {
-                delete edge;
-            }
+    [[nodiscard]] sg_edge *find_edge(const long long from, const long long to, const long long label) const {
+        const auto it = edge_index_.find({from, to, label});
+        return it == edge_index_.end() ? nullptr : it->second;
+    }
+
+    void set_timestamp(sg_edge *edge, const long long timestamp) {
+        edge->timestamp = timestamp;
+        if (store_ == adjacency_store::slab) {
+            out_slabs_.set_timestamp(edge->s, edge);
+            in_slabs_.set_timestamp(edge->d, edge);
         }
+    }
 
-        // Free memory for the timed edges list
-        while (time_list_head) {
-            timed_edge *temp = time_list_head;
-            time_list_head = time_list_head->next;
-            delete temp;
+    // Bookkeeping for an edge already detached from the adjacency store;
+    // deletes it.
+    void release_edge(sg_edge *edge) {
+        const long long from = edge->s, to = edge->d, label = edge->label;
+
+        // Remove from the edge indexes and, if still queued, from the time list
+        if (index_edge_ids_) edge_ids_.erase(edge->id);
+        edge_index_.erase({from, to, label});
+        time_list.erase(edge);
+
+        edge_num--;
+        if (edge_num < 0) std::cerr << "ERROR: edge_num < 0\n";
+        label_count[label]--;
+        if (is_initial_transition(label)) EINIT_count--;
+
+        // Update degrees (exactly once)
+        vertices_[from].out_degree--;
+        vertices_[to].in_degree--;
+
+        // Vertices without edges leave the window
+        auto try_remove_isolated_vertex = [&](long long v) {
+            if (!vertices_[v].present()) {
+                vertex_num--;
+                isolated_vertices.push_back(v);
+            }
+        };
+
+        try_remove_isolated_vertex(from);
+        if (to != from) {
+            try_remove_isolated_vertex(to);
         }
+
+        // The edge object itself is released with its pane
     }
 
-    void add_timed_edge(timed_edge *cur) // append an edge to the time sequence list
-    {
-        if (!time_list_head) {
-            time_list_head = cur;
-            time_list_tail = cur;
+    // Moves a refreshed edge to the back of the time list and repoints the
+    // indexes at its new address.
+    sg_edge *relocate(sg_edge *edge) {
+        sg_edge *moved = time_list.relocate(edge);
+        if (store_ == adjacency_store::slab) {
+            out_slabs_.replace(moved->s, edge, moved);
+            in_slabs_.replace(moved->d, edge, moved);
         } else {
-            time_list_tail->next = cur;
-            cur->prev = time_list_tail;
-            time_list_tail = cur;
+            out_lists_.replace(moved->s, edge, moved);
+            in_lists_.replace(moved->d, edge, moved);
         }
+        edge_index_[{moved->s, moved->d, moved->label}] = moved;
+        if (index_edge_ids_) edge_ids_[moved->id] = moved;
+        return moved;
     }
 
-    void delete_timed_edge(timed_edge *cur) // delete an edge from the time sequence list
-    {
-        if (!cur)
+    void append_adjacency(sg_edge *edge) {
+        if (store_ == adjacency_store::slab) {
+            out_slabs_.append(edge->s, edge);
+            in_slabs_.append(edge->d, edge);
             return;
+        }
+        out_lists_.append(edge->s, edge);
+        in_lists_.append(edge->d, edge);
+    }
 
-        cur->edge_pt->time_pos = nullptr; // disassociate the sg_edge from the timed edge
-
-        if (cur == time_list_head) {
-            time_list_head = cur->next;
-            if (time_list_head)
-                time_list_head->prev = nullptr;
+    void erase_adjacency(const sg_edge *edge) {
+        if (store_ == adjacency_store::slab) {
+            out_slabs_.erase(edge->s, edge);
+            in_slabs_.erase(edge->d, edge);
+            return;
         }
+        in_lists_.erase(edge->d, edge);
+        out_lists_.erase(edge->s, edge);
+    }
 
-        if (cur == time_list_tail) {
-            time_list_tail = cur->prev;
-            if (time_list_tail)
-                time_list_tail->next = nullptr;
+public:
+    explicit streaming_graph(const std::vector<long long>& initial_transitions_,
+                             const adjacency_store store = adjacency_store::map,
+                             const bool index_edge_ids = true,
+                             const long long pane_width = 1)
+        : time_list(pane_width), index_edge_ids_(index_edge_ids), store_(store) {
+        for (const auto label : initial_transitions_) {
+            initial_transitions.insert(label);
         }
+    }
 
-        if (cur->prev) cur->prev->next = cur->next;
-        if (cur->next) cur->next->prev = cur->prev;
+    [[nodiscard]] bool is_initial_transition(const long long label) const {
+        return initial_transitions.find(label) != initial_transitions.end();
+    }
+
+    [[nodiscard]] bool has_vertex(const long long v) const {
+        return static_cast<std::size_t>(v) < vertices_.size() && vertices_[v].present();
+    }
+
+    [[nodiscard]] int out_degree(const long long v) const {
+        return static_cast<std::size_t>(v) < vertices_.size() ? vertices_[v].out_degree : 0;
+    }
+
+    [[nodiscard]] int in_degree(const long long v) const {
+        return static_cast<std::size_t>(v) < vertices_.size() ? vertices_[v].in_degree : 0;
+    }
 
-        delete cur;
+    // Edge with the given ID, or nullptr if it is not in the window (or the
+    // graph was built without the edge ID index).
+    [[nodiscard]] sg_edge *edge_by_id(const long long id) const {
+        const auto it = edge_ids_.find(id);
+        return it == edge_ids_.end() ? nullptr : it->second;
     }
 
     sg_edge *insert_edge(const long long edge_id, const long long from, long long to, const long long label,
                          const long long timestamp,
                          const long long expiration_time) {
-        // Check if the edge already exists in the adjacency list
-        for (auto &[to_vertex, existing_edge]: adjacency_list[from]) {
-            if (existing_edge->label == label && to_vertex == to) {
-                if (existing_edge->timestamp < timestamp) existing_edge->timestamp = timestamp;
-                delete_timed_edge(existing_edge->time_pos); // remove the old timed edge from the time list
-                return existing_edge;
-            }
+        // Check if the edge already exists in the window
+        if (sg_edge *existing_edge = find_edge(from, to, label)) {
+            if (existing_edge->timestamp < timestamp) set_timestamp(existing_edge, timestamp);
+            return relocate(existing_edge); // move it to the back of the time list
         }
 
         edge_num++;
+        if (static_cast<std::size_t>(label) >= label_count.size()) label_count.resize(label + 1, 0);
         label_count[label]++;
         if (is_initial_transition(label)) EINIT_count++;
 
-        auto *edge = new sg_edge(edge_id, from, to, label, timestamp, expiration_time);
-        edge_id_to_edge[edge_id] = edge;
+        sg_edge *edge = time_list.create(edge_id, from, to, label, timestamp, expiration_time);
+        if (index_edge_ids_) edge_ids_[edge_id] = edge;
+        edge_index_.emplace(edge_key{from, to, label}, edge);
 
-        // Add the edge to the adjacency list if it doesn't exist
-        if (adjacency_list[from].empty()) {
-            adjacency_list[from] = std::vector<std::pair<long long, sg_edge *> >();
-        }
-        adjacency_list.at(from).emplace_back(to, edge);
-        if (reverse_adjacency_list[to].empty()) {
-            reverse_adjacency_list[to] = std::vector<std::pair<long long, sg_edge *> >();
-        }
-        reverse_adjacency_list[to].emplace_back(from, edge);
+        append_adjacency(edge);
 
-        if (out_degree.find(from) == out_degree.end()) {
-            out_degree[from] = 0;
-            if (in_degree.find(from) == in_degree.end()) {
-                in_degree[from] = 0;
-            }
-            vertex_num++;
-        }
-        if (in_degree.find(to) == in_degree.end()) {
-            in_degree[to] = 0;
-            if (out_degree.find(to) == out_degree.end()) {
-                out_degree[to] = 0;
-            }
-            vertex_num++;
-        }
-        out_degree[from]++;
-        in_degree[to]++;
-
-        // Store edge endpoints for future rank updates
-        edge_endpoints[edge_id] = {from, to};
+        if (const auto top = static_cast<std::size_t>(std::max(from, to)); top >= vertices_.size())
+            vertices_.resize(top + 1);
+        if (!vertices_[from].present()) vertex_num++;
+        vertices_[from].out_degree++;
+        if (!vertices_[to].present()) vertex_num++;
+        vertices_[to].in_degree++;
 
         return edge;
     }
 
     bool remove_edge(long long from, long long to, long long label, long long current_time) {
-        if (adjacency_list.find(from) == adjacency_list.end() || adjacency_list[from].empty()) {
-            return false;
-        }
-
-        auto &edges = adjacency_list[from];
-        for (auto it = edges.begin(); it != edges.end(); ++it) {
-            if (sg_edge *edge = it->second; it->first == to && edge->label == label) {
-
-                // Remove from edge_id_to_edge map
-                edge_id_to_edge.erase(edge->id);
-
-                // Remove from reverse adjacency list
-                if (auto rit = reverse_adjacency_list.find(to); rit != reverse_adjacency_list.end()) {
-                    auto& rev = rit->second;
-                    for (auto rj = rev.begin(); rj != rev.end(); ++rj) {
-                        if (rj->second == edge) {
-                            rev.erase(rj);
-                            break;
-                        }
-                    }
-                    if (rev.empty()) reverse_adjacency_list.erase(rit);
-                }
-
-                // Remove the edge from the adjacency list
-                bool should_erase_from = false;
-                edges.erase(it);
-                edge_num--;
-                if (edge_num < 0) std::cerr << "ERROR: edge_num < 0\n";
-                label_count[label]--;
-                if (label_count[label] == 0) {
-                    label_count.erase(label);
-                }
-                if (is_initial_transition(label)) EINIT_count--;
-                if (edges.empty()) {
-                    should_erase_from = true;
-                }
-
-                // Update degrees (exactly once)
-                out_degree[from]--;
-                in_degree[to]--;
-
-                // Remove isolated vertices safely
-                auto try_remove_isolated_vertex = [&](long long v) {
-                    auto out_it = out_degree.find(v);
-                    auto in_it = in_degree.find(v);
-
-                    if (out_it != out_degree.end() && in_it != in_degree.end() &&
-                        out_it->second == 0 && in_it->second == 0) {
-                        out_degree.erase(out_it);
-                        in_degree.erase(in_it);
-
-                        auto adj_it = adjacency_list.find(v);
-                        if (adj_it != adjacency_list.end() && adj_it->second.empty()) {
-                            adjacency_list.erase(adj_it);
-                        }
-
-                        vertex_num--;
-                        }
-                };
-
-                try_remove_isolated_vertex(from);
-                if (to != from) {
-                    try_remove_isolated_vertex(to);
-                }
-
-                if (should_erase_from) {
-                    adjacency_list.erase(from);
-                }
-
-                // Now safe to delete the edge object
-                delete edge;
-
-                return true;
-            }
-        }
-        return false;
+        sg_edge *edge = find_edge(from, to, label);
+        if (!edge) return false;
+        erase_adjacency(edge);
+        release_edge(edge);
+        return true;
     }
 
     void expire(long long eviction_time, std::vector<expired_edge_info>& deleted_edges) {
-        while (time_list_head) {
-            sg_edge* cur = time_list_head->edge_pt;
+        while (sg_edge* cur = time_list.front()) {
             // edges are ordered oldest-first; stop when the front edge is still alive
             if (cur->timestamp >= eviction_time)
                 break;
 
             deleted_edges.push_back({cur->s, cur->d, cur->label, cur->id});
-
-            // Detach and delete the timed_edge node from the list
-            timed_edge* te = time_list_head;
-            time_list_head = time_list_head->next;
-            if (time_list_head)
-                time_list_head->prev = nullptr;
-            else
-                time_list_tail = nullptr;
-            te->edge_pt = nullptr;
-            delete te;
-
-            // Null out time_pos before remove_edge so the adjacency-list
-            // removal does not try to touch the already-deleted timed_edge
-            cur->time_pos = nullptr;
+            time_list.pop_front();
 
             // remove_edge handles adjacency list, degrees, ranking, and deletes cur
             remove_edge(cur->s, cur->d, cur->label, eviction_time);
         }
     }
 
-    // return a vector of pointers instead of copies
-    std::vector<sg_edge*> get_all_suc_ptrs(long long s) {
-        std::vector<sg_edge*> sucs;
-        auto it = adjacency_list.find(s);
-        if (it == adjacency_list.end()) return sucs;
-        for (auto& [to, edge] : it->second)
-            sucs.emplace_back(edge);
-        return sucs;
+    // Calls f(const neighbor &) for every out-edge of s, label partition by
+    // label.
+    template<typename F>
+    void for_each_successor(const long long s, F &&f) const {
+        outgoing([&](const auto &adj) { adj.for_each(s, f); });
     }
 
-    // return all edges pointing TO d: each edge has edge->s = predecessor, edge->d = d
-    std::vector<sg_edge*> get_all_pred_ptrs(long long d) {
-        std::vector<sg_edge*> preds;
-        auto it = reverse_adjacency_list.find(d);
-        if (it == reverse_adjacency_list.end()) return preds;
-        for (auto& [from, edge] : it->second)
-            preds.emplace_back(edge);
-        return preds;
+    // Calls f(const neighbor &) for every out-edge of s with the given label.
+    template<typename F>
+    void for_each_successor(const long long s, const long long label, F &&f) const {
+        outgoing([&](const auto &adj) { adj.for_each(s, label, f); });
     }
 
-    void shift_timed_edge(timed_edge *to_insert, timed_edge *target) {
-        if (!to_insert || !target) return;
+    // Calls f(const neighbor &) for every in-edge of d, label partition by
+    // label.
+    template<typename F>
+    void for_each_predecessor(const long long d, F &&f) const {
+        incoming([&](const auto &adj) { adj.for_each(d, f); });
+    }
 
-        // Remove to_insert from its current position
-        if (to_insert->prev) to_insert->prev->next = to_insert->next;
-        if (to_insert->next) to_insert->next->prev = to_insert->prev;
-        if (to_insert == time_list_head) time_list_head = to_insert->next;
-        if (to_insert == time_list_tail) time_list_tail = to_insert->prev;
+    // Calls f(const neighbor &) for every in-edge of d with the given label.
+    template<typename F>
+    void for_each_predecessor(const long long d, const long long label, F &&f) const {
+        incoming([&](const auto &adj) { adj.for_each(d, label, f); });
+    }
 
-        // Insert to_insert right after target
-        to_insert->next = target->next;
-        to_insert->prev = target;
-        if (target->next) target->next->prev = to_insert;
-        target->next = to_insert;
+    // Calls f(v) for every vertex with at least one out-edge.
+    template<typename F>
+    void for_each_source_vertex(F &&f) const {
+        outgoing([&](const auto &adj) { adj.for_each_vertex(f); });
+    }
 
-        // Update tail if necessary
-        if (target == time_list_tail) time_list_tail = to_insert;
+    // Checkpoint: every edge once in time list order, both adjacency lists as
+    // edge IDs (so their order survives a restore), then the counters.
+    void save(CheckpointWriter &w) const {
+        w.put(shed_count);
+        w.put(edge_num);
+        w.put(EINIT_count);
+        w.put(vertex_num);
+
+        // every edge of the window is queued in the time list
+        w.put_size(time_list.size());
+        time_list.for_each([&](const sg_edge *edge) {
+            w.put(edge->id);
+            w.put(edge->s);
+            w.put(edge->d);
+            w.put(edge->label);
+            w.put(edge->timestamp);
+            w.put(edge->expiration_time);
+        });
+
+        const auto put_adjacency = [&](const auto &adj) {
+            w.put_size(adj.vertex_count());
+            adj.for_each_vertex([&](const long long v) {
+                w.put(v);
+                w.put_size(adj.degree(v));
+                adj.for_each(v, [&](const neighbor &n) { w.put(n.edge->id); });
+            });
+        };
+        outgoing(put_adjacency);
+        incoming(put_adjacency);
+
+        w.put_vector(label_count);
+        w.put_vector(vertices_);
+    }
 
-        to_insert->edge_pt->expiration_time = target->edge_pt->expiration_time;
-        to_insert->edge_pt->timestamp = target->edge_pt->timestamp;
+    // Restore state written by save() into an empty graph.
+    void load(CheckpointReader &r) {
+        r.get(shed_count);
+        r.get(edge_num);
+        r.get(EINIT_count);
+        r.get(vertex_num);
+
+        const std::size_t edge_count = r.get_size();
+        std::unordered_map<long long, sg_edge *> edges_by_id;
+        edges_by_id.reserve(edge_count);
+        edge_index_.reserve(edge_count);
+        for (std::size_t i = 0; i < edge_count; i++) {
+            const auto id = r.get<long long>();
+            const auto s = r.get<long long>();
+            const auto d = r.get<long long>();
+            const auto label = r.get<long long>();
+            const auto timestamp = r.get<long long>();
+            const auto expiration_time = r.get<long long>();
+            sg_edge *e = time_list.create(id, s, d, label, timestamp, expiration_time);
+            edges_by_id[id] = e;
+            edge_index_.emplace(edge_key{s, d, label}, e);
+        }
+        if (index_edge_ids_) edge_ids_ = edges_by_id;
+        const auto edge = [&](const long long id) {
+            const auto it = edges_by_id.find(id);
+            if (it == edges_by_id.end()) r.fail("unknown edge ID");
+            return it->second;
+        };
+
+        const auto get_adjacency = [&](auto &adj) {
+            for (std::size_t i = r.get_size(); i > 0; i--) {
+                const auto v = r.get<long long>();
+                for (std::size_t n = r.get_size(); n > 0; n--) adj.append(v, edge(r.get<long long>()));
+            }
+        };
+        if (store_ == adjacency_store::slab) {
+            get_adjacency(out_slabs_);
+            get_adjacency(in_slabs_);
+        } else {
+            get_adjacency(out_lists_);
+            get_adjacency(in_lists_);
+        }
+
+        r.get_vector(label_count);
+        r.get_vector(vertices_);
     }
 
-    [[nodiscard]] size_t getUsedMemory() const {
-        return MemoryEstimatorAdjL::estimate_adjacency_list(adjacency_list);
+    void measure_memory(memory_usage &m) const {
+        m.out_adjacency = outgoing([](const auto &adj) { return adj.memory(); });
+        m.in_adjacency = incoming([](const auto &adj) { return adj.memory(); });
+        m.edge_index = memory_estimate::hashed(edge_index_) + memory_estimate::hashed(edge_ids_);
+        m.vertices = memory_estimate::vector(vertices_) + memory_estimate::vector(label_count) +
+                     memory_estimate::vector(isolated_vertices);
+        m.time_list = time_list.memory();
     }
 
     std::map<unsigned int, unsigned int> get_degree_map(const long long vertex_id) {
         std::map<unsigned int, unsigned int> degree_map;
-        for (auto [edge_id, edge_ptr] : adjacency_list[vertex_id]) {
-            if (const long long label = edge_ptr->label; degree_map.find(label) != degree_map.end())
-                degree_map[label]++;
-            else
-                degree_map[label] = 1;
-        }
+        outgoing([&](const auto &adj) {
+            adj.for_each_label(vertex_id, [&](const long long label, const std::size_t count) {
+                degree_map[label] += count;
+            });
+        });
         return degree_map;
     };
 
     void printGraph() const {
-        if (adjacency_list.empty()) {
+        if (edge_num == 0) {
             std::cout << "╔════════════════╗\n";
             std::cout << "║ Empty Graph    ║\n";
             std::cout << "╚════════════════╝\n";
@@ -405,19 +886,20 @@ public:
             32 - std::to_string(static_cast<long long>(edge_num)).length(), ' ') << "║\n";
         std::cout << "╚════════════════════════════════════════╝\n\n";
 
-        for (const auto &[from, edges]: adjacency_list) {
+        for_each_source_vertex([&](const long long from) {
             std::cout << "Vertex " << from;
 
-            for (size_t i = 0; i < edges.size(); ++i) {
-                const auto &[to, edge] = edges[i];
-                bool isLast = (i == edges.size() - 1);
+            const int degree = out_degree(from);
+            int i = 0;
+            for_each_successor(from, [&](const neighbor &n) {
+                bool isLast = (++i == degree);
 
-                std::cout << (isLast ? "└──" : "├──") << "→ " << to;
-                std::cout << " [label:" << edge->label
-                        << " ts:" << edge->timestamp << "]\n";
-            }
+                std::cout << (isLast ? "└──" : "├──") << "→ " << n.vertex;
+                std::cout << " [label:" << n.label
+                        << " ts:" << n.timestamp << "]\n";
+            });
             std::cout << "\n";
-        }
+        });
     }
 };
 
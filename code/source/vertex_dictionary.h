@@ -0,0 +1,130 @@
+#ifndef VERTEX_DICTIONARY_H
+#define VERTEX_DICTIONARY_H
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "checkpoint_io.h"
+
+// ---------------------------------------------------------------------------
+// VertexDictionary  —  external vertex IDs (any long long) to dense 32-bit IDs
+//
+// IDs are assigned at ingest, so the graph and the forests only ever see
+// dense IDs and no longer truncate 64-bit vertex IDs. A dense ID whose vertex
+// has left the window is returned to a free list and reused. Vertices that
+// may have left are queued as candidates; reclaim() releases those that are
+// neither in the window nor held by the query state.
+// ---------------------------------------------------------------------------
+class VertexDictionary {
+    std::unordered_map<long long, uint32_t> ids_; // external -> dense
+    std::vector<long long> external_;             // dense -> external
+    std::vector<uint32_t> free_ids_;
+
+    std::vector<uint32_t> candidates_;
+    std::vector<bool> pending_; // dense ID is in candidates_
+    std::size_t kept_ = 0;      // candidates left queued by the last reclaim()
+
+public:
+    // New candidates that make reclaim_due() true between slide boundaries.
+    static constexpr std::size_t reclaim_batch = 1 << 12;
+
+    uint32_t encode(const long long v) {
+        if (const auto it = ids_.find(v); it != ids_.end()) return it->second;
+        uint32_t id;
+        if (!free_ids_.empty()) {
+            id = free_ids_.back();
+            free_ids_.pop_back();
+            external_[id] = v;
+        } else {
+            if (external_.size() == std::numeric_limits<uint32_t>::max()) {
+                std::cerr << "ERROR: more than 2^32 - 1 live vertices" << std::endl;
+                exit(1);
+            }
+            id = static_cast<uint32_t>(external_.size());
+            external_.push_back(v);
+            pending_.push_back(false);
+        }
+        ids_.emplace(v, id);
+        return id;
+    }
+
+    [[nodiscard]] long long external(const long long id) const {
+        return external_[id];
+    }
+
+    // Queue a vertex that may no longer be referenced.
+    void add_candidate(const long long id) {
+        if (pending_[id]) return;
+        pending_[id] = true;
+        candidates_.push_back(static_cast<uint32_t>(id));
+    }
+
+    [[nodiscard]] bool reclaim_due() const {
+        return candidates_.size() >= kept_ + reclaim_batch;
+    }
+
+    // For each candidate: drop it from the queue if in_window(id) (it is queued
+    // again when it next becomes isolated), keep it queued if held(id), and
+    // release it otherwise. Returns the number of released IDs.
+    template<typename InWindow, typename Held>
+    std::size_t reclaim(InWindow in_window, Held held) {
+        std::size_t released = 0;
+        std::size_t kept = 0;
+        for (const uint32_t id : candidates_) {
+            if (in_window(id)) {
+                pending_[id] = false;
+            } else if (held(id)) {
+                candidates_[kept++] = id;
+            } else {
+                pending_[id] = false;
+                ids_.erase(external_[id]);
+                free_ids_.push_back(id);
+                released++;
+            }
+        }
+        candidates_.resize(kept);
+        kept_ = kept;
+        return released;
+    }
+
+    void save(CheckpointWriter &w) const {
+        w.put_vector(external_);
+        w.put_vector(free_ids_);
+        w.put_vector(candidates_);
+        w.put_vector(pending_);
+        w.put_size(kept_);
+    }
+
+    // Restore state written by save(); the external -> dense map is rebuilt
+    // from the live IDs.
+    void load(CheckpointReader &r) {
+        r.get_vector(external_);
+        r.get_vector(free_ids_);
+        r.get_vector(candidates_);
+        r.get_vector(pending_);
+        kept_ = r.get_size();
+
+        std::vector<bool> free(external_.size(), false);
+        for (const uint32_t id : free_ids_) free[id] = true;
+        ids_.clear();
+        ids_.reserve(external_.size() - free_ids_.size());
+        for (uint32_t id = 0; id < external_.size(); id++) {
+            if (!free[id]) ids_.emplace(external_[id], id);
+        }
+    }
+
+    // Live vertices.
+    [[nodiscard]] std::size_t size() const {
+        return ids_.size();
+    }
+
+    // Dense IDs handed out so far, i.e. the bound of an array indexed by ID.
+    [[nodiscard]] std::size_t id_bound() const {
+        return external_.size();
+    }
+};
+
+#endif //VERTEX_DICTIONARY_H